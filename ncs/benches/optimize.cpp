@@ -1,8 +1,12 @@
 /* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
 
+#include <cstdio>
 #include <random>
 #include <string>
 #include <benchmark/benchmark.h>
+#include <ncs/sched/pool.hpp>
+#include <ncs/world/journal.hpp>
+#include <ncs/world/prefab.hpp>
 #include <ncs/world/world.hpp>
 
 struct Position
@@ -68,6 +72,116 @@ static void BM_EntityWithComponents(benchmark::State &state)
 
 BENCHMARK(BM_EntityWithComponents)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMillisecond);
 
+static void BM_SpawnBatch(benchmark::State &state)
+{
+	/* same three components as chained set<T> would add, without the walk along the graph */
+	const std::vector<Position> positions(state.range(0), { 1.0f, 2.0f, 3.0f });
+	const std::vector<Velocity> velocities(state.range(0), { 0.1f, 0.2f, 0.3f });
+	const std::vector<Health> healths(state.range(0), { 100, 100 });
+	for (auto _: state)
+	{
+		ncs::World world;
+		benchmark::DoNotOptimize(world.spawn_batch<Position, Velocity, Health>(positions, velocities, healths));
+	}
+}
+
+BENCHMARK(BM_SpawnBatch)->Range(1 << 10, 1 << 19)->Unit(benchmark::kMillisecond);
+
+static void BM_Instantiate(benchmark::State &state)
+{
+	/* spawn_batch's archetype, with the rows replicated from a prefab instead of copied from spans */
+	for (auto _: state)
+	{
+		ncs::World world;
+		ncs::Prefab prefab(world);
+		prefab.set(Position { 1.0f, 2.0f, 3.0f }).set(Velocity { 0.1f, 0.2f, 0.3f }).set(Health { 100, 100 });
+		benchmark::DoNotOptimize(world.instantiate(prefab, state.range(0)));
+	}
+}
+
+BENCHMARK(BM_Instantiate)->Range(1 << 10, 1 << 19)->Unit(benchmark::kMillisecond);
+
+static void BM_SnapshotLoad(benchmark::State &state)
+{
+	/* arg 0 is the entity count, arg 1 picks copy or adopt */
+	const std::string path = "ncs_bench.snapshot";
+	{
+		ncs::World world;
+		world.spawn_batch<Position, Velocity>(state.range(0), [](size_t, Position &, Velocity &) {});
+		world.save(path);
+	}
+
+	for (auto _: state)
+	{
+		ncs::World world;
+		world.component<Position>();
+		world.component<Velocity>();
+		benchmark::DoNotOptimize(world.load(path, static_cast<ncs::Restore>(state.range(1))));
+	}
+
+	std::remove(path.c_str());
+}
+
+BENCHMARK(BM_SnapshotLoad)
+		->ArgsProduct({ { 1 << 16, 1 << 20 }, { static_cast<int>(ncs::Restore::COPY),
+		                                      static_cast<int>(ncs::Restore::ADOPT) } })
+		->Unit(benchmark::kMillisecond);
+
+static void BM_JournalFrame(benchmark::State &state)
+{
+	/* one row in a hundred written per tick; the frame size is reported next to the raw column bytes */
+	ncs::World world;
+	const auto handles = world.spawn_batch<Position, Velocity>(state.range(0), [](size_t, Position &, Velocity &) {});
+	ncs::Journal journal(world);
+	std::vector<std::byte> frame;
+	journal.commit(frame);
+
+	ncs::World replica;
+	replica.component<Position>();
+	replica.component<Velocity>();
+	ncs::Replay replay(replica);
+	replay.apply(frame);
+
+	for (auto _: state)
+	{
+		world.advance();
+		for (size_t i = 0; i < handles.size(); i += 100)
+		{
+			world.get<Position>(handles[i])->x += 1.0f;
+			world.mark_changed<Position>(handles[i]);
+		}
+
+		frame.clear();
+		journal.commit(frame);
+		benchmark::DoNotOptimize(replay.apply(frame));
+	}
+
+	state.counters["frame_bytes"] = static_cast<double>(frame.size());
+	state.counters["column_bytes"] = static_cast<double>(state.range(0) * 2 * sizeof(Position));
+}
+
+BENCHMARK(BM_JournalFrame)->Range(1 << 12, 1 << 20)->Unit(benchmark::kMicrosecond);
+
+static void BM_ArchetypeGrowth(benchmark::State &state)
+{
+	/* arg 1 picks the storage layout; chunked growth never copies existing rows */
+	const auto storage = static_cast<ncs::Storage>(state.range(1));
+	for (auto _: state)
+	{
+		ncs::World world(storage);
+		for (auto i = 0; i < state.range(0); ++i)
+		{
+			const auto entity = world.entity();
+			world.set<Position>(entity, { 1.0f, 2.0f, 3.0f });
+		}
+	}
+}
+
+BENCHMARK(BM_ArchetypeGrowth)
+		->ArgsProduct({ { 1 << 12, 1 << 16, 1 << 20 }, { static_cast<int>(ncs::Storage::CONTIGUOUS),
+		                                                 static_cast<int>(ncs::Storage::CHUNKED) } })
+		->Unit(benchmark::kMillisecond);
+
 static void BM_ComponentAccess(benchmark::State &state)
 {
 	ncs::World world;
@@ -262,6 +376,97 @@ static void BM_QueryPerformance(benchmark::State& state)
 
 BENCHMARK(BM_QueryPerformance)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMillisecond);
 
+static void BM_EachPerformance(benchmark::State &state)
+{
+	ncs::World world;
+
+	/* same world layout as BM_QueryPerformance */
+	for (auto i = 0; i < state.range(0); ++i)
+	{
+		auto entity = world.entity();
+		world.set<Position>(entity, { static_cast<float>(i), static_cast<float>(i * 2), static_cast<float>(i * 3) });
+
+		if (i % 4 != 0)
+			world.set<Velocity>(entity, { 0.1f, 0.2f, 0.3f });
+
+		if (i % 2 == 0)
+			world.set<Health>(entity, { 100, 100 });
+
+		if (i % 4 == 0)
+			world.set<Name>(entity, Name(std::string("Entity") + std::to_string(i)));
+	}
+
+	for (auto _: state)
+	{
+		auto total_movement = 0.0f;
+		auto total_health = 0;
+
+		world.each<Position, const Velocity>([&total_movement](const Position &pos, const Velocity &vel)
+		{
+			total_movement += pos.x + vel.y;
+		});
+
+		world.each_chunk<const Health>([&total_health](std::span<const ncs::Entity>, std::span<const Health> health)
+		{
+			for (const auto &h: health)
+				total_health += h.current;
+		});
+
+		benchmark::DoNotOptimize(total_movement);
+		benchmark::DoNotOptimize(total_health);
+	}
+}
+
+BENCHMARK(BM_EachPerformance)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMillisecond);
+
+static void BM_ParallelEach(benchmark::State &state)
+{
+	/* arg 1 is the thread count, calling thread included */
+	ncs::World world;
+	ncs::ThreadPool pool(state.range(1));
+
+	for (auto i = 0; i < state.range(0); ++i)
+	{
+		const auto entity = world.entity();
+		world.set<Position>(entity, { static_cast<float>(i), static_cast<float>(i * 2), static_cast<float>(i * 3) })
+				->set<Velocity>(entity, { 0.1f, 0.2f, 0.3f })
+				->set<Health>(entity, { i % 100, 100 });
+
+		if (i % 2 == 0)
+			world.set<AI>(entity, { i % 3, 0.0f, 0.0f });
+	}
+
+	for (auto _: state)
+	{
+		/* movement, ai and regen fused into one pass per entity */
+		world.par_each<Position, const Velocity, Health>(pool, [](Position &pos, const Velocity &vel, Health &health)
+		{
+			constexpr auto dt = 0.016f;
+			for (auto step = 0; step < 8; ++step)
+			{
+				pos.x += vel.x * dt;
+				pos.y += vel.y * dt;
+				pos.z += vel.z * dt;
+			}
+
+			if (health.current < health.max)
+				health.current += 1;
+		});
+
+		world.par_each<AI, const Position>(pool, [](AI &ai, const Position &pos)
+		{
+			ai.state = (ai.state + 1) % 3;
+			ai.target_x = pos.x + 10.0f;
+			ai.target_y = pos.y + 10.0f;
+		});
+	}
+}
+
+BENCHMARK(BM_ParallelEach)
+		->ArgsProduct({ { 1 << 16, 1 << 20 }, { 1, 2, 4, 8, 16 } })
+		->UseRealTime()
+		->Unit(benchmark::kMillisecond);
+
 static void BM_HeavyQueryWorkload(benchmark::State& state)
 {
     /* each benchmark iteration should create a fresh world */
@@ -2,23 +2,69 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <span>
 #include <unordered_map>
 #include <vector>
 #include <ncs/types.hpp>
+#include <ncs/base/signature.hpp>
 #include <ncs/storage/column.hpp>
 
 namespace ncs
 {
 	struct Column;
 	struct Archetype;
-	struct GraphEdge;
 	struct Record;
 
-	struct GraphEdge
+	/*
+	 * single-component transitions of one archetype; component id -> index of the destination in the world's
+	 * archetype table. open addressing with linear probing, at most half full; lookups never allocate
+	 */
+	struct EdgeTable
 	{
-		Archetype* from;
+		static constexpr uint32_t NONE = ~0u;
+
+		[[nodiscard]] uint32_t find(Component c) const;
+
+		void insert(Component c, uint32_t to);
+
+	private:
+		struct Slot
+		{
+			Component id = 0;
+			uint32_t to = NONE; /* NONE marks an empty slot */
+		};
+
+		static size_t bucket(const Component c)
+		{
+			return static_cast<uint32_t>(c) * 0x9E3779B1u >> 16; /* fibonacci hashing; sequential ids spread out */
+		}
+
+		std::vector<Slot> slots; /* power of two, empty until the first edge */
+		size_t count = 0;
+	};
+
+	inline uint32_t EdgeTable::find(const Component c) const
+	{
+		if (slots.empty())
+			return NONE;
+
+		const size_t mask = slots.size() - 1;
+		for (size_t i = bucket(c) & mask;; i = (i + 1) & mask)
+		{
+			if (slots[i].to == NONE)
+				return NONE;
+			if (slots[i].id == c)
+				return slots[i].to;
+		}
+	}
+
+	/* a transition adding and removing several components at once */
+	struct BundleEdge
+	{
+		std::vector<Component> delta; /* sorted added ids, a separator, sorted removed ids */
 		Archetype* to;
-		Component id; /* what component causes the transition */
 	};
 
 	struct Record
@@ -30,23 +76,100 @@ namespace ncs
 	struct Archetype
 	{
 		/* graph structure */
-		std::unordered_map<Component, GraphEdge*> add_edge;
-		std::unordered_map<Component, GraphEdge*> remove_edge;
+		EdgeTable add_edge;
+		EdgeTable remove_edge;
+		std::unordered_map<uint64_t, BundleEdge> bundle_edge; /* keyed by the hash of the delta */
 
-		std::unordered_map<Entity, size_t> entity_rows;
-		std::unordered_map<Component, Column> columns;
+		std::vector<Column> columns; /* data components only, in component order; tags have none */
+		std::vector<uint16_t> slots; /* component id -> index in columns; dense up to the largest column id */
 		std::vector<Component> components;
-		std::vector<Entity> entities;
+		std::vector<Entity> entities; /* contiguous layout only; chunked archetypes keep the handles in their chunks */
+		Signature signature; /* bitset over components; has() is a bit test */
 		size_t entity_count = 0;
+		size_t capacity = 0; /* rows there is storage for */
 		uint64_t id = 0;
+		uint32_t index = 0;   /* position in the world's archetype table */
+		uint64_t version = 0; /* bumped on every append and remove; row pointers are stale once it moves */
 		DirtyFlags flags = {};
 
-		[[nodiscard]] bool has(Component c) const;
+		/* chunked layout; every chunk holds the handles and all columns of chunk_rows rows, one after another */
+		static constexpr size_t CHUNK_SIZE = 16 * 1024;
+		Storage storage = Storage::CONTIGUOUS;
+		std::vector<void *> chunks;
+		std::vector<Entity *> entity_blocks; /* the handles at the front of each chunk */
+		size_t chunk_rows = 0;
+		size_t chunk_shift = 0; /* log2 of chunk_rows */
+
+		Archetype() = default;
+
+		~Archetype();
+
+		Archetype(const Archetype &) = delete;
+
+		Archetype &operator=(const Archetype &) = delete;
+
+		static constexpr uint16_t NO_COLUMN = 0xFFFF;
+
+		[[nodiscard]] bool has(Component c) const
+		{
+			return signature.test(c);
+		}
+
+		[[nodiscard]] Column *column(Component c); /* nullptr for tags, pairs, shared values and absent ids */
+
+		[[nodiscard]] const Column *column(Component c) const;
+
+		Column &add_column(Component c); /* before the first row; returns the existing column if there is one */
 
 		size_t append(Entity entity);
 
-		void remove(Entity entity);
+		size_t append(std::span<const Entity> batch); /* one growth for the whole batch; returns the first row */
+
+		void reserve(size_t rows); /* room for rows entities without further growth in append */
+
+		void remove(size_t row); /* swaps the last row into row */
 
 		void move(size_t row, Archetype* dest, Entity entity);
+
+		[[nodiscard]] size_t run(size_t row) const; /* rows stored contiguously from row onwards */
+
+		[[nodiscard]] Entity *entity_at(size_t row); /* unchecked; row must be below capacity */
+
+		[[nodiscard]] const Entity *entity_at(size_t row) const;
+
+	private:
+		void grow_chunk();
 	};
+
+	inline size_t Archetype::run(const size_t row) const
+	{
+		if (storage == Storage::CONTIGUOUS)
+			return entity_count - row;
+
+		return std::min(entity_count, (row / chunk_rows + 1) * chunk_rows) - row;
+	}
+
+	inline Column *Archetype::column(const Component c)
+	{
+		/* an array index, no hashing; pair and shared ids lie far past the table */
+		return c < slots.size() && slots[c] != NO_COLUMN ? &columns[slots[c]] : nullptr;
+	}
+
+	inline const Column *Archetype::column(const Component c) const
+	{
+		return const_cast<Archetype *>(this)->column(c);
+	}
+
+	inline Entity *Archetype::entity_at(const size_t row)
+	{
+		if (storage == Storage::CONTIGUOUS)
+			return entities.data() + row;
+
+		return entity_blocks[row >> chunk_shift] + (row & (chunk_rows - 1));
+	}
+
+	inline const Entity *Archetype::entity_at(const size_t row) const
+	{
+		return const_cast<Archetype *>(this)->entity_at(row);
+	}
 }
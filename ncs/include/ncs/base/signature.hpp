@@ -0,0 +1,79 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <span>
+#include <vector>
+#include <ncs/types.hpp>
+
+namespace ncs
+{
+	/* fixed-width component bitset; ids past the inline words spill into a sorted overflow list */
+	struct Signature
+	{
+		static constexpr size_t WORDS = 4; /* 256 inline component ids */
+		static constexpr size_t INLINE_BITS = WORDS * 64;
+
+		uint64_t words[WORDS] = {};
+		std::vector<Component> overflow; /* sorted ids >= INLINE_BITS */
+
+		Signature() = default;
+
+		explicit Signature(std::span<const Component> components);
+
+		void set(Component c);
+
+		void reset(Component c);
+
+		[[nodiscard]] bool test(Component c) const;
+
+		[[nodiscard]] bool contains(const Signature &mask) const; /* (sig & mask) == mask */
+
+		[[nodiscard]] bool intersects(const Signature &mask) const; /* (sig & mask) != 0 */
+
+		bool operator==(const Signature &other) const;
+
+		[[nodiscard]] uint64_t hash() const; /* equal signatures hash alike; anything else may collide */
+	};
+
+	inline uint64_t Signature::hash() const
+	{
+		constexpr uint64_t K = 0x9E3779B97F4A7C15ULL;
+
+		/* every word is mixed on its own, so the loop vectorizes; then folded and finalized once */
+		uint64_t h = 0;
+		for (size_t i = 0; i < WORDS; ++i)
+			h ^= std::rotl((words[i] ^ K * (i + 1)) * K, static_cast<int>(i * 16));
+
+		for (const Component c: overflow)
+			h = (h ^ c) * K;
+
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+	inline bool Signature::test(const Component c) const
+	{
+		if (c < INLINE_BITS) [[likely]]
+			return (words[c >> 6] >> (c & 63)) & 1;
+
+		return std::ranges::binary_search(overflow, c);
+	}
+
+	inline bool Signature::contains(const Signature &mask) const
+	{
+		/* branchless over the inline words so the compiler emits a single vector compare */
+		uint64_t missing = 0;
+		for (size_t i = 0; i < WORDS; ++i)
+			missing |= mask.words[i] & ~words[i];
+
+		if (missing)
+			return false;
+
+		return mask.overflow.empty() || std::ranges::includes(overflow, mask.overflow);
+	}
+}
@@ -0,0 +1,98 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#pragma once
+
+#include <algorithm>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <ncs/types.hpp>
+
+namespace ncs
+{
+	/*
+	 * a type whose object may be moved to new storage by copying its bytes and forgetting the old ones.
+	 * trivially copyable types qualify; specialize for types known to be safe, e.g. ones holding a unique_ptr
+	 */
+	template<typename T>
+	struct is_trivially_relocatable : std::bool_constant<std::is_trivially_copyable_v<T> > {};
+
+	template<typename T>
+	inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+	Component next_type_id(); /* process-wide; thread-safe */
+
+	/* the id of T, shared by every world; assigned on first use, a single static load afterwards */
+	template<typename T>
+	Component type_id()
+	{
+		static const Component id = next_type_id();
+		return id;
+	}
+
+	/*
+	 * a hash of T's name; unlike type_id the same in every process, so it can name T in files. the name is cut out of
+	 * the compiler's spelling of this function, "[with T = X; ...]" or "[T = X]", and hashed with 64-bit FNV-1a
+	 */
+	template<typename T>
+	constexpr uint64_t type_key()
+	{
+		constexpr std::string_view function = __PRETTY_FUNCTION__;
+		constexpr size_t first = function.find("T = ") + 4;
+		constexpr size_t last = std::min(function.find(';', first), function.rfind(']'));
+
+		uint64_t hash = 0xCBF29CE484222325ULL;
+		for (const char c: function.substr(first, last - first))
+			hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001B3ULL;
+		return hash;
+	}
+
+	/* what a column needs to know about its component type; null hooks mean plain bytes */
+	struct TypeInfo
+	{
+		uint64_t key = 0;                                /* type_key(); 0 until registered */
+		size_t size = 0;                                 /* 0 for tags */
+		bool trivial = true;                             /* rows may be saved and restored as raw bytes */
+		void (*relocate)(void *, void *, size_t) = {};   /* move-constructs count objects into dst and destroys src */
+		void (*destroy)(void *) = {};
+
+		template<typename T>
+		static TypeInfo of();
+	};
+
+	template<typename T>
+	TypeInfo TypeInfo::of()
+	{
+		TypeInfo info;
+		info.key = type_key<T>();
+		info.trivial = std::is_trivially_copyable_v<T>;
+		if constexpr (!std::is_empty_v<T>)
+		{
+			info.size = sizeof(T);
+			if constexpr (!is_trivially_relocatable_v<T>)
+			{
+				info.relocate = [](void *dst, void *src, const size_t count)
+				{
+					T *to = static_cast<T *>(dst);
+					T *from = static_cast<T *>(src);
+					for (size_t i = 0; i < count; ++i)
+					{
+						new(to + i) T(std::move(from[i]));
+						from[i].~T();
+					}
+				};
+			}
+
+			if constexpr (!std::is_trivially_destructible_v<T>)
+			{
+				info.destroy = [](void *ptr)
+				{
+					static_cast<T *>(ptr)->~T();
+				};
+			}
+		}
+
+		return info;
+	}
+}
@@ -2,10 +2,10 @@
 
 #pragma once
 
-#include <vector>
+#include <span>
 #include <ncs/types.hpp>
 
 namespace ncs
 {
-	uint64_t archash(const std::vector<Component>& components);
+	uint64_t archash(std::span<const Component> components);
 }
\ No newline at end of file
@@ -0,0 +1,169 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <vector>
+#include <ncs/types.hpp>
+
+namespace ncs
+{
+	/* query()'s cached rows of one archetype */
+	template<typename... Components>
+	struct QuerySegment
+	{
+		uint64_t version = ~0ULL; /* archetype version the rows were built against */
+		std::vector<std::tuple<Entity, Components *...> > rows;
+	};
+
+	/*
+	 * what query() returns: the cached segments of every matching archetype, read in place as one sequence. copying
+	 * it copies two pointers, not rows. it goes stale with the cache (see World::query)
+	 */
+	template<typename... Components>
+	class QueryRows
+	{
+	public:
+		using value_type = std::tuple<Entity, Components *...>;
+		using Segment = QuerySegment<Components...>;
+
+		class iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = QueryRows::value_type;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const value_type *;
+			using reference = const value_type &;
+
+			iterator() = default;
+
+			iterator(const std::vector<Segment> *segments, size_t segment);
+
+			reference operator*() const;
+
+			pointer operator->() const;
+
+			iterator &operator++();
+
+			iterator operator++(int);
+
+			bool operator==(const iterator &other) const;
+
+		private:
+			void skip(); /* onto the next segment with rows, or the end */
+
+			const std::vector<Segment> *segments = nullptr;
+			size_t segment = 0;
+			size_t row = 0;
+		};
+
+		QueryRows(const std::vector<Segment> &segments, const std::vector<size_t> &starts);
+
+		[[nodiscard]] size_t size() const;
+
+		[[nodiscard]] bool empty() const;
+
+		const value_type &operator[](size_t index) const; /* a binary search over the segment starts */
+
+		[[nodiscard]] iterator begin() const;
+
+		[[nodiscard]] iterator end() const;
+
+	private:
+		const std::vector<Segment> *segments;
+		const std::vector<size_t> *starts; /* row index each segment starts at, then the total */
+	};
+
+	template<typename... Components>
+	QueryRows<Components...>::iterator::iterator(const std::vector<Segment> *segments, const size_t segment)
+		: segments(segments), segment(segment)
+	{
+		skip();
+	}
+
+	template<typename... Components>
+	auto QueryRows<Components...>::iterator::operator*() const -> reference
+	{
+		return (*segments)[segment].rows[row];
+	}
+
+	template<typename... Components>
+	auto QueryRows<Components...>::iterator::operator->() const -> pointer
+	{
+		return &(*segments)[segment].rows[row];
+	}
+
+	template<typename... Components>
+	auto QueryRows<Components...>::iterator::operator++() -> iterator &
+	{
+		if (++row == (*segments)[segment].rows.size())
+		{
+			row = 0;
+			++segment;
+			skip();
+		}
+
+		return *this;
+	}
+
+	template<typename... Components>
+	auto QueryRows<Components...>::iterator::operator++(int) -> iterator
+	{
+		iterator copy = *this;
+		++*this;
+		return copy;
+	}
+
+	template<typename... Components>
+	bool QueryRows<Components...>::iterator::operator==(const iterator &other) const
+	{
+		return segment == other.segment && row == other.row;
+	}
+
+	template<typename... Components>
+	void QueryRows<Components...>::iterator::skip()
+	{
+		while (segment < segments->size() && (*segments)[segment].rows.empty())
+			++segment;
+	}
+
+	template<typename... Components>
+	QueryRows<Components...>::QueryRows(const std::vector<Segment> &segments, const std::vector<size_t> &starts)
+		: segments(&segments), starts(&starts) {}
+
+	template<typename... Components>
+	size_t QueryRows<Components...>::size() const
+	{
+		return starts->back();
+	}
+
+	template<typename... Components>
+	bool QueryRows<Components...>::empty() const
+	{
+		return size() == 0;
+	}
+
+	template<typename... Components>
+	auto QueryRows<Components...>::operator[](const size_t index) const -> const value_type &
+	{
+		/* the last start not above index; empty segments share their start with the next one */
+		const size_t segment = std::upper_bound(starts->begin(), starts->end() - 1, index) - starts->begin() - 1;
+		return (*segments)[segment].rows[index - (*starts)[segment]];
+	}
+
+	template<typename... Components>
+	auto QueryRows<Components...>::begin() const -> iterator
+	{
+		return { segments, 0 };
+	}
+
+	template<typename... Components>
+	auto QueryRows<Components...>::end() const -> iterator
+	{
+		return { segments, segments->size() };
+	}
+}
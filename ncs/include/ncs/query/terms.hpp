@@ -0,0 +1,166 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+#include <ncs/types.hpp>
+#include <ncs/storage/column.hpp>
+
+namespace ncs
+{
+	/* rows whose T was added at or after the query's tick; the callback still receives T & */
+	template<typename T>
+	struct Added {};
+
+	/* rows whose T was written at or after the query's tick; the callback still receives T & */
+	template<typename T>
+	struct Changed {};
+
+	/* archetypes must have T; nothing is passed to the callback */
+	template<typename T>
+	struct With {};
+
+	/* archetypes with T are never visited */
+	template<typename T>
+	struct Without {};
+
+	/* T * in the callback; nullptr in archetypes without T */
+	template<typename T>
+	struct Optional {};
+
+	/* const T & in the callback; the single value every row of the archetype shares, see World::set_shared */
+	template<typename T>
+	struct Shared {};
+
+	/* archetypes must have at least one of Ts; nothing is passed to the callback */
+	template<typename... Ts>
+	struct Or {};
+
+	/* how a term takes part in archetype matching */
+	enum class TermKind : uint8_t
+	{
+		REQUIRE,
+		EXCLUDE,
+		OPTIONAL,
+		ANY,
+	};
+
+	struct term_base
+	{
+		static constexpr bool plain = false;    /* a bare component; every row of a matching run is visited */
+		static constexpr bool filtered = false; /* column() and row() can reject */
+		static constexpr bool shared = false;   /* one value for every row of an archetype */
+
+		static bool column(const Column *, Tick)
+		{
+			return true;
+		}
+
+		static bool row(const Column *, size_t, Tick)
+		{
+			return true;
+		}
+	};
+
+	/*
+	 * what a query term means. component is the id matched against archetypes, value what the callback gets
+	 * (a reference, a pointer for OPTIONAL, nothing for void); column() and row() filter whole columns and rows
+	 */
+	template<typename Term>
+	struct term : term_base
+	{
+		using component = std::remove_cv_t<Term>;
+		using value = Term;
+		static constexpr TermKind kind = TermKind::REQUIRE;
+		static constexpr bool plain = true;
+	};
+
+	template<typename T>
+	struct term<Added<T> > : term_base
+	{
+		static_assert(!std::is_empty_v<T>, "tags keep no ticks");
+
+		using component = std::remove_cv_t<T>;
+		using value = T;
+		static constexpr TermKind kind = TermKind::REQUIRE;
+		static constexpr bool filtered = true;
+
+		static bool column(const Column *c, const Tick since)
+		{
+			return c->added_max >= since;
+		}
+
+		static bool row(const Column *c, const size_t row, const Tick since)
+		{
+			return c->added(row) >= since;
+		}
+	};
+
+	template<typename T>
+	struct term<Changed<T> > : term_base
+	{
+		static_assert(!std::is_empty_v<T>, "tags keep no ticks");
+
+		using component = std::remove_cv_t<T>;
+		using value = T;
+		static constexpr TermKind kind = TermKind::REQUIRE;
+		static constexpr bool filtered = true;
+
+		static bool column(const Column *c, const Tick since)
+		{
+			return c->changed_max >= since;
+		}
+
+		static bool row(const Column *c, const size_t row, const Tick since)
+		{
+			return c->changed(row) >= since;
+		}
+	};
+
+	template<typename T>
+	struct term<With<T> > : term_base
+	{
+		using component = std::remove_cv_t<T>;
+		using value = void;
+		static constexpr TermKind kind = TermKind::REQUIRE;
+	};
+
+	template<typename T>
+	struct term<Without<T> > : term_base
+	{
+		using component = std::remove_cv_t<T>;
+		using value = void;
+		static constexpr TermKind kind = TermKind::EXCLUDE;
+	};
+
+	template<typename T>
+	struct term<Optional<T> > : term_base
+	{
+		using component = std::remove_cv_t<T>;
+		using value = T;
+		static constexpr TermKind kind = TermKind::OPTIONAL;
+	};
+
+	template<typename T>
+	struct term<Shared<T> > : term_base
+	{
+		using component = Shared<std::remove_cv_t<T> >; /* the tag marking archetypes that share a T */
+		using value = const std::remove_cv_t<T>;
+		static constexpr TermKind kind = TermKind::REQUIRE;
+		static constexpr bool shared = true;
+	};
+
+	template<typename... Ts>
+	struct term<Or<Ts...> > : term_base
+	{
+		static_assert(sizeof...(Ts) > 0, "Or needs at least one component");
+
+		using components = std::tuple<std::remove_cv_t<Ts>...>;
+		using value = void;
+		static constexpr TermKind kind = TermKind::ANY;
+	};
+
+	template<typename... Terms>
+	inline constexpr bool all_plain_v = (term<Terms>::plain && ...);
+}
@@ -0,0 +1,71 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <ncs/types.hpp>
+
+namespace ncs
+{
+	/* work-stealing pool; every participant owns a deque, pops its own front and steals from the others' back */
+	class ThreadPool
+	{
+	public:
+		explicit ThreadPool(size_t threads = std::thread::hardware_concurrency()); /* counts the calling thread */
+
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool &) = delete;
+
+		ThreadPool &operator=(const ThreadPool &) = delete;
+
+		[[nodiscard]] size_t size() const; /* workers plus the calling thread */
+
+		/* runs fn(ctx, i) for every i in [0, count); the caller helps and returns once all are done */
+		void run(size_t count, void (*fn)(void *, size_t), void *ctx);
+
+		template<typename Func>
+		void run(size_t count, Func &&func);
+
+	private:
+		struct Task
+		{
+			void (*fn)(void *, size_t);
+			void *ctx;
+			size_t index;
+			std::atomic<size_t> *pending; /* owned by the run() call that queued it */
+		};
+
+		struct Queue
+		{
+			std::mutex lock;
+			std::deque<Task> tasks;
+		};
+
+		bool pop(size_t self, Task &task);
+
+		void work(size_t self);
+
+		std::vector<std::unique_ptr<Queue> > queues; /* queue 0 belongs to outside callers */
+		std::vector<std::thread> workers;
+		std::mutex sleep_lock;
+		std::condition_variable wake;
+		std::atomic<size_t> queued;
+		bool stopping;
+	};
+
+	template<typename Func>
+	void ThreadPool::run(const size_t count, Func &&func)
+	{
+		run(count, [](void *ctx, const size_t index)
+		{
+			(*static_cast<std::remove_reference_t<Func> *>(ctx))(index);
+		}, &func);
+	}
+}
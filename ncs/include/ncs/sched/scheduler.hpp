@@ -0,0 +1,82 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <ncs/base/signature.hpp>
+#include <ncs/sched/pool.hpp>
+#include <ncs/world/world.hpp>
+
+namespace ncs
+{
+	/* runs systems in stages; systems whose declared access does not conflict share a stage and run in parallel */
+	class Scheduler
+	{
+	public:
+		Scheduler(World &world, ThreadPool &pool);
+
+		/*
+		 * Access lists the components the system touches; const T is a read, T is a write.
+		 * func is either func(World &) or a per-row callback taking the Access components in order.
+		 * a func(World &) may resolve queries nobody prepared, which inserts into world maps; it gets a stage of its own
+		 */
+		template<typename... Access, typename Func>
+		Scheduler &system(Func &&func);
+
+		void run(); /* runs every stage in registration order; returns when the last stage is done */
+
+		[[nodiscard]] const std::vector<std::vector<size_t> > &stages(); /* system indices per stage */
+
+	private:
+		struct System
+		{
+			Signature reads;
+			Signature writes;
+			std::function<void(World &)> run;
+			bool exclusive = false; /* func(World &); conflicts with every other system */
+		};
+
+		void build();
+
+		[[nodiscard]] static bool conflicts(const System &a, const System &b);
+
+		World &world;
+		ThreadPool &pool;
+		std::vector<System> systems;
+		std::vector<std::vector<size_t> > layers;
+		bool dirty;
+	};
+
+	template<typename... Access, typename Func>
+	Scheduler &Scheduler::system(Func &&func)
+	{
+		System sys;
+		/* only terms handing out data count as access; With, Without and Or just shape the match */
+		([&]
+		{
+			using T = term<Access>;
+			if constexpr (!std::is_void_v<typename T::value>)
+				(std::is_const_v<typename T::value> ? sys.reads : sys.writes).set(world.component<typename T::component>());
+		}(), ...);
+
+		if constexpr (std::is_invocable_v<Func &, World &>)
+		{
+			sys.run = std::forward<Func>(func);
+			sys.exclusive = true;
+		}
+		else
+		{
+			/* resolve everything now so workers never insert into world maps */
+			world.prepare<Access...>();
+			sys.run = [func = std::forward<Func>(func)](World &w) mutable
+			{
+				w.each<Access...>(func);
+			};
+		}
+
+		systems.emplace_back(std::move(sys));
+		dirty = true;
+		return *this;
+	}
+}
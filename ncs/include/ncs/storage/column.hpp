@@ -2,15 +2,34 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
 #include <ncs/types.hpp>
 
 namespace ncs
 {
 	struct Column
 	{
+		static constexpr size_t ALIGNMENT = 64; /* cache line; batches split on row multiples of 64 never share one */
+
+		Component id = 0; /* the component stored */
 		void *data = nullptr;
 		size_t size = 0;
 		size_t capacity = 0;
+		bool owned = true; /* false while data points into an adopted snapshot; never freed, copied out on growth */
+		void (*relocate_fn)(void *, void *, size_t) = {}; /* TypeInfo::relocate; null relocates with memcpy */
+
+		/* change tracking; one tick per row. contiguous columns keep them here, chunked ones next to each block */
+		std::vector<Tick> added_ticks;
+		std::vector<Tick> changed_ticks;
+		Tick added_max = 0;   /* newest tick in added; a column below a filter's tick is skipped whole */
+		Tick changed_max = 0;
+
+		/* chunked storage; non-owning pointers into the archetype's chunks, one per chunk */
+		std::vector<char *> blocks;
+		std::vector<Tick *> tick_blocks; /* per chunk: the added tick of every row, then the changed ones */
+		size_t block_shift = 0; /* log2 of rows per chunk */
 
 		Column();
 
@@ -24,10 +43,88 @@ namespace ncs
 
 		Column &operator=(Column &&other) noexcept;
 
-		void resize(size_t nsz);
+		void resize(size_t nsz, size_t rows = ~size_t { 0 }); /* the first rows rows are relocated; all by default */
 
 		void clear();
 
+		void adopt(void *rows, size_t count); /* takes count rows at rows as its storage, without a copy */
+
 		[[nodiscard]] void *get(size_t row) const;
+
+		[[nodiscard]] void *at(size_t row) const; /* unchecked; row must be below the archetype's row count */
+
+		void relocate(void *dst, void *src, size_t count = 1) const; /* dst is raw storage; src is left destroyed */
+
+		[[nodiscard]] Tick added(size_t row) const;
+
+		[[nodiscard]] Tick changed(size_t row) const;
+
+		void mark_added(size_t row, Tick tick); /* also counts as a change */
+
+		void mark_changed(size_t row, Tick tick);
+
+		void copy_ticks(size_t row, const Column &src, size_t src_row); /* the row keeps its history across moves */
+
+		[[nodiscard]] static void *allocate(size_t bytes); /* cache-line aligned; release with std::free */
+
+	private:
+		[[nodiscard]] Tick *tick_at(size_t row, bool change) const; /* the row's added or changed tick */
 	};
+
+	inline void *Column::at(const size_t row) const
+	{
+		if (data)
+			return static_cast<char *>(data) + row * size;
+
+		const size_t mask = (size_t { 1 } << block_shift) - 1;
+		return blocks[row >> block_shift] + (row & mask) * size;
+	}
+
+	inline Tick *Column::tick_at(const size_t row, const bool change) const
+	{
+		if (blocks.empty())
+			return const_cast<Tick *>(change ? changed_ticks.data() : added_ticks.data()) + row;
+
+		const size_t mask = (size_t { 1 } << block_shift) - 1;
+		return tick_blocks[row >> block_shift] + (change ? mask + 1 : 0) + (row & mask);
+	}
+
+	inline Tick Column::added(const size_t row) const
+	{
+		return *tick_at(row, false);
+	}
+
+	inline Tick Column::changed(const size_t row) const
+	{
+		return *tick_at(row, true);
+	}
+
+	inline void Column::mark_added(const size_t row, const Tick tick)
+	{
+		*tick_at(row, false) = tick;
+		added_max = tick;
+		mark_changed(row, tick);
+	}
+
+	inline void Column::mark_changed(const size_t row, const Tick tick)
+	{
+		*tick_at(row, true) = tick;
+		changed_max = tick;
+	}
+
+	inline void Column::copy_ticks(const size_t row, const Column &src, const size_t src_row)
+	{
+		*tick_at(row, false) = src.added(src_row);
+		*tick_at(row, true) = src.changed(src_row);
+		added_max = std::max(added_max, src.added(src_row));
+		changed_max = std::max(changed_max, src.changed(src_row));
+	}
+
+	inline void Column::relocate(void *dst, void *src, const size_t count) const
+	{
+		if (relocate_fn)
+			relocate_fn(dst, src, count);
+		else
+			std::memcpy(dst, src, size * count);
+	}
 }
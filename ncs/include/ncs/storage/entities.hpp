@@ -0,0 +1,78 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#pragma once
+
+#include <memory>
+#include <span>
+#include <vector>
+#include <ncs/types.hpp>
+#include <ncs/archetype/archetypes.hpp>
+
+namespace ncs
+{
+	/* one slot per entity id; the record row doubles as the free-list link while the slot is dead */
+	struct EntitySlot
+	{
+		Record record = {};
+		Generation generation = 0;
+		bool alive = false;
+	};
+
+	/* paged sparse table indexed by the 48-bit entity id; pages are never moved so slots stay pointer-stable */
+	class EntityTable
+	{
+	public:
+		static constexpr size_t PAGE_SHIFT = 12; /* 4096 slots per page */
+		static constexpr size_t PAGE_SIZE = size_t { 1 } << PAGE_SHIFT;
+		static constexpr size_t PAGE_MASK = PAGE_SIZE - 1;
+
+		EntityTable();
+
+		[[nodiscard]] Entity create(); /* pops the free list or grows the table */
+
+		void create(std::span<Entity> out); /* fills out with live handles; grows the table at most once */
+
+		bool destroy(Entity entity); /* bumps the generation and pushes the id onto the free list */
+
+		/* starts over with exactly these live handles, records cleared; other ids are free with the given generations */
+		void restore(std::span<const Entity> live, std::span<const Generation> generations);
+
+		[[nodiscard]] EntitySlot *find(Entity entity) const; /* live slot matching the handle's generation */
+
+		[[nodiscard]] EntitySlot *slot(uint64_t id) const; /* slot of a raw id regardless of liveness */
+
+		[[nodiscard]] size_t alive() const;
+
+		[[nodiscard]] uint64_t size() const; /* ids handed out so far; slot() is valid below it */
+
+	private:
+		static constexpr uint64_t NIL = ENTITY_MASK; /* end of the free list */
+
+		std::vector<std::unique_ptr<EntitySlot[]> > pages;
+		uint64_t free_head; /* last despawned id; reused first */
+		uint64_t next_id;   /* next never-used id */
+		size_t alive_count;
+	};
+
+	/* hot path; a handle check is a bound check and one indexed load */
+	inline EntitySlot *EntityTable::find(const Entity entity) const
+	{
+		const uint64_t id = entity & ENTITY_MASK;
+		if (id >= next_id)
+			return nullptr;
+
+		EntitySlot *s = &pages[id >> PAGE_SHIFT][id & PAGE_MASK];
+		if (!s->alive || s->generation != static_cast<Generation>(entity >> GENERATION_SHIFT))
+			return nullptr;
+
+		return s;
+	}
+
+	inline EntitySlot *EntityTable::slot(const uint64_t id) const
+	{
+		if (id >= next_id)
+			return nullptr;
+
+		return &pages[id >> PAGE_SHIFT][id & PAGE_MASK];
+	}
+}
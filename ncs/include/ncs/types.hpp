@@ -2,13 +2,36 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace ncs
 {
-	using Component = uint16_t;
+	using Component = uint32_t;
 	using Entity = uint64_t;
 	using Generation = uint16_t;
+	using Tick = uint32_t; /* world change tick; see World::advance */
+
+	constexpr Component PAIR_FLAG = Component { 1 } << 31; /* set on relationship pair ids; type ids never reach it */
+	constexpr Component SHARED_FLAG = Component { 1 } << 30; /* set on shared value ids, which sort before pairs */
+
+	constexpr uint64_t ENTITY_MASK = 0x0000FFFFFFFFFFFF; /* 48 lower bits for entity id */
+	constexpr uint64_t GENERATION_SHIFT = 48; /* we need to shift 16 bits upper to accommodate the entity bits */
+	constexpr Generation MAX_GENERATION = 0xFFFF; /* for 16-bit generation */
+
+	/* archetype column layout */
+	enum class Storage : uint8_t
+	{
+		CONTIGUOUS, /* one block per column; grows by doubling and moves rows */
+		CHUNKED,    /* fixed-size chunks holding every column; rows never move on growth */
+	};
+
+	/* how World::load takes column data out of a snapshot file */
+	enum class Restore : uint8_t
+	{
+		COPY,  /* bulk copy into freshly allocated columns; the file is unmapped afterwards */
+		ADOPT, /* columns point into a private mapping of the file; pages are copied by the kernel on first write */
+	};
 
 	enum class DirtyFlags : uint64_t
 	{
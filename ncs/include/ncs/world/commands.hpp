@@ -0,0 +1,148 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <ncs/types.hpp>
+#include <ncs/storage/column.hpp>
+#include <ncs/world/world.hpp>
+
+namespace ncs
+{
+	/*
+	 * structural changes recorded now and applied later; recording is safe from any thread, apply() is not.
+	 * commands recorded for one entity on one thread apply in order; across threads the order is unspecified
+	 */
+	class Commands
+	{
+	public:
+		explicit Commands(World &world);
+
+		~Commands(); /* pending commands are dropped, not applied */
+
+		Commands(const Commands &) = delete;
+
+		Commands &operator=(const Commands &) = delete;
+
+		template<typename T>
+		Commands &set(Entity entity, const T &data);
+
+		template<typename T> requires (!std::is_lvalue_reference_v<T>)
+		Commands &set(Entity entity, T &&data); /* moves data into the buffer */
+
+		template<typename T>
+		Commands &remove(Entity entity);
+
+		Commands &despawn(Entity entity); /* the entity's other commands are dropped */
+
+		/* plays everything back; entities moving between the same two archetypes are moved as one batch */
+		void apply();
+
+		void clear(); /* drops everything recorded */
+
+	private:
+		enum class Op : uint8_t
+		{
+			SET,
+			REMOVE,
+			DESPAWN
+		};
+
+		struct Command
+		{
+			Entity entity;
+			Op op;
+			Component (*resolve)(World &);         /* component ids are resolved on apply, never while recording */
+			void *value = nullptr;                 /* SET only; lives in the shard's blocks */
+			void (*relocate)(void *, void *) = {}; /* move-constructs into the first slot and destroys the second */
+			void (*destroy)(void *) = {};
+		};
+
+		struct Shard
+		{
+			std::mutex lock;
+			std::vector<Command> commands;
+			std::vector<void *> blocks; /* value storage; never moves so values stay put until applied */
+			size_t used = 0;            /* bytes taken from the last block */
+		};
+
+		static constexpr size_t SHARDS = 16;
+		static constexpr size_t BLOCK_SIZE = 4096;
+
+		Shard &shard(); /* a thread always maps to the same shard, which keeps its commands in order */
+
+		static void *allocate(Shard &shard, size_t size, size_t align); /* shard.lock must be held */
+
+		void push(const Command &command);
+
+		template<typename U, typename V>
+		Commands &record(Entity entity, V &&data); /* a SET of U built from data */
+
+		static void release(Shard &shard); /* frees the blocks; values must be gone already */
+
+		World &world;
+		std::array<Shard, SHARDS> shards;
+	};
+
+	template<typename T>
+	Commands &Commands::set(const Entity entity, const T &data)
+	{
+		return record<std::remove_cv_t<T> >(entity, data);
+	}
+
+	template<typename T> requires (!std::is_lvalue_reference_v<T>)
+	Commands &Commands::set(const Entity entity, T &&data)
+	{
+		return record<std::remove_cv_t<T> >(entity, std::move(data));
+	}
+
+	template<typename U, typename V>
+	Commands &Commands::record(const Entity entity, V &&data)
+	{
+		static_assert(alignof(U) <= Column::ALIGNMENT, "over-aligned components are not supported");
+
+		Shard &s = shard();
+		std::lock_guard guard(s.lock);
+
+		void *value = allocate(s, sizeof(U), alignof(U));
+		new(value) U(std::forward<V>(data));
+		s.commands.push_back({
+			entity,
+			Op::SET,
+			[](World &w)
+			{
+				return w.component<U>();
+			},
+			value,
+			[](void *dst, void *src)
+			{
+				new(dst) U(std::move(*static_cast<U *>(src)));
+				static_cast<U *>(src)->~U();
+			},
+			[](void *ptr)
+			{
+				static_cast<U *>(ptr)->~U();
+			}
+		});
+		return *this;
+	}
+
+	template<typename T>
+	Commands &Commands::remove(const Entity entity)
+	{
+		push({
+			entity,
+			Op::REMOVE,
+			[](World &w)
+			{
+				return w.component<T>();
+			}
+		});
+		return *this;
+	}
+}
@@ -0,0 +1,188 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#pragma once
+
+#include <algorithm>
+#include <span>
+#include <vector>
+#include <ncs/types.hpp>
+#include <ncs/archetype/archetypes.hpp>
+#include <ncs/world/world.hpp>
+
+namespace ncs
+{
+	/* the hierarchy relation; world.add<ChildOf>(child, parent) */
+	struct ChildOf {};
+
+	/*
+	 * propagates Local to Global down ChildOf links: global = compose(&parent global, local), or compose(nullptr, local)
+	 * for roots and for children whose parent lacks either transform. all children of a parent share an archetype,
+	 * so archetypes are walked parents first, each costs one parent lookup, and its rows are a linear pass
+	 */
+	template<typename Local, typename Global>
+	class Hierarchy
+	{
+		static_assert(!std::is_empty_v<Local> && !std::is_empty_v<Global>, "transforms need a column");
+
+	public:
+		explicit Hierarchy(World &world);
+
+		/*
+		 * recomputes rows whose Local, or whose parent's Global, changed at or after since; returns the rows written.
+		 * archetypes that gained or lost rows since the last pass (spawns, reparenting, despawned parents) are redone whole
+		 */
+		template<typename Compose>
+		size_t propagate(Compose &&compose, Tick since);
+
+		template<typename Compose>
+		size_t propagate(Compose &&compose); /* changes made in the world's current tick */
+
+	private:
+		static constexpr Entity ROOT = ~Entity { 0 };
+
+		struct Step
+		{
+			Archetype *archetype;
+			Entity parent; /* ROOT when there is nothing to inherit */
+			uint32_t depth;
+		};
+
+		void rebuild(std::span<Archetype *const> matched); /* depth-sorts the matching archetypes */
+
+		World &world;
+		std::vector<Step> order;     /* parents before children */
+		size_t matched_count = 0;    /* size of the match list when order was built */
+		uint64_t versions = ~0ULL;   /* sum of their versions; any append, remove or move changes it */
+		std::vector<uint64_t> seen;  /* version of each archetype at its last pass, by index */
+	};
+
+	template<typename Local, typename Global>
+	Hierarchy<Local, Global>::Hierarchy(World &world) : world(world) {}
+
+	template<typename Local, typename Global>
+	template<typename Compose>
+	size_t Hierarchy<Local, Global>::propagate(Compose &&compose, const Tick since)
+	{
+		const std::span<Archetype *const> matched = world.matching<Local, Global>();
+		uint64_t sum = 0;
+		for (const Archetype *arch: matched)
+			sum += arch->version;
+
+		/* reparenting and despawns move rows, so the order only goes stale when a version moves */
+		if (matched.size() != matched_count || sum != versions)
+		{
+			rebuild(matched);
+			matched_count = matched.size();
+			versions = sum;
+		}
+
+		const Component local_id = world.component<Local>();
+		const Component global_id = world.component<Global>();
+		const Tick now = world.tick();
+
+		size_t written = 0;
+		for (const Step &step: order)
+		{
+			Archetype *arch = step.archetype;
+			const Column &local = *arch->column(local_id);
+			Column &global = *arch->column(global_id);
+
+			if (arch->index >= seen.size())
+				seen.resize(arch->index + 1, ~0ULL);
+
+			/* rows that moved in keep their ticks, so an archetype whose rows changed is redone whole */
+			auto moved = seen[arch->index] != arch->version;
+			seen[arch->index] = arch->version;
+
+			const Global *parent = nullptr;
+			if (step.parent != ROOT)
+			{
+				const Record *record = world.record_of(step.parent);
+				const Column &column = *record->archetype->column(global_id);
+				parent = static_cast<const Global *>(column.at(record->row));
+				moved |= column.changed(record->row) >= since; /* the parent was written; every row follows it */
+			}
+
+			if (!moved && local.changed_max < since) /* the subtree below this level is untouched */
+				continue;
+
+			for (size_t row = 0; row < arch->entity_count; ++row)
+			{
+				if (!moved && local.changed(row) < since)
+					continue;
+
+				*static_cast<Global *>(global.at(row)) = compose(parent, *static_cast<const Local *>(local.at(row)));
+				global.mark_changed(row, now);
+				++written;
+			}
+		}
+
+		return written;
+	}
+
+	template<typename Local, typename Global>
+	template<typename Compose>
+	size_t Hierarchy<Local, Global>::propagate(Compose &&compose)
+	{
+		return propagate(std::forward<Compose>(compose), world.tick());
+	}
+
+	template<typename Local, typename Global>
+	void Hierarchy<Local, Global>::rebuild(const std::span<Archetype *const> matched)
+	{
+		constexpr uint32_t UNKNOWN = ~0u;
+		constexpr uint32_t VISITING = UNKNOWN - 1;
+
+		const Component relation = world.component<ChildOf>();
+		const Component local = world.component<Local>();
+		const Component global = world.component<Global>();
+
+		/* the parent shared by an archetype's rows; pair ids sit at the end of the sorted component list */
+		const auto parent_of = [&](const Archetype *arch)
+		{
+			for (auto it = std::ranges::lower_bound(arch->components, PAIR_FLAG); it != arch->components.end(); ++it)
+			{
+				const auto [rel, target] = world.pair_of(*it);
+				if (rel != relation)
+					continue;
+
+				const Archetype *above = world.archetype_of(target);
+				return above && above->has(local) && above->has(global) ? target : ROOT;
+			}
+
+			return ROOT;
+		};
+
+		/* a parent's archetype matches too, so indices of the match list cover every archetype on a chain */
+		uint32_t last = 0;
+		for (const Archetype *arch: matched)
+			last = std::max(last, arch->index);
+
+		std::vector<uint32_t> depth(last + 1, UNKNOWN);
+		std::vector<Entity> parents(last + 1, ROOT);
+		std::vector<Archetype *> chain;
+		for (Archetype *arch: matched)
+		{
+			/* climb until an archetype of known depth or a root; everything on the way is resolved at once */
+			chain.clear();
+			Archetype *at = arch;
+			while (at && depth[at->index] == UNKNOWN)
+			{
+				depth[at->index] = VISITING;
+				chain.emplace_back(at);
+				parents[at->index] = parent_of(at);
+				at = parents[at->index] == ROOT ? nullptr : world.archetype_of(parents[at->index]);
+			}
+
+			uint32_t d = at && depth[at->index] != VISITING ? depth[at->index] + 1 : 0; /* a cycle is cut where found */
+			for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+				depth[(*it)->index] = d++;
+		}
+
+		order.clear();
+		for (Archetype *arch: matched)
+			order.push_back({ arch, parents[arch->index], depth[arch->index] });
+
+		std::ranges::stable_sort(order, {}, &Step::depth);
+	}
+}
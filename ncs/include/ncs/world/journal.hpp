@@ -0,0 +1,80 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <ncs/types.hpp>
+#include <ncs/archetype/archetypes.hpp>
+#include <ncs/world/world.hpp>
+
+namespace ncs
+{
+	/*
+	 * records what changes in a world, one frame per commit(): archetype moves (which cover spawns, adds and removes),
+	 * despawns, and the rows of every trivially copyable column written since the last commit. frames are
+	 * length-prefixed and compact; Replay plays them onto another world.
+	 *
+	 * frame: u32 payload length, then varint tick, varint op count, the ops, varint group count, the value groups.
+	 *   op 0 archetype: varint index, varint n, n u64 type keys; sent before the first move into it
+	 *   op 1 move:      varint entity, varint archetype index + 1, 0 for no components
+	 *   op 2 despawn:   varint entity
+	 *   group:          u64 type key, varint size, varint rows, rows zigzag varint entity deltas, then the values, each
+	 *                   XOR'd with the row before it in the group and cut into (varint zeros, varint n, n bytes) runs
+	 * pairs, shared values and components that are not trivially copyable are left out
+	 */
+	class Journal
+	{
+	public:
+		explicit Journal(World &world); /* starts with every live entity, so the first frame rebuilds the world */
+
+		~Journal(); /* stops recording */
+
+		Journal(const Journal &) = delete;
+
+		Journal &operator=(const Journal &) = delete;
+
+		/* appends a frame; returns its size with the prefix. once per tick, after its writes and before advance() */
+		size_t commit(std::vector<std::byte> &out);
+
+		/* for World; you shouldn't be calling these */
+		void moved(Entity entity, const Archetype *archetype);
+
+		void despawned(Entity entity);
+
+		void detach(); /* the world is going away */
+
+	private:
+		World *world;
+		std::vector<std::byte> ops; /* encoded since the last commit */
+		size_t op_count = 0;
+		std::vector<bool> announced; /* by archetype index */
+		Tick since = 0;              /* rows written at or after this tick go into the next frame */
+	};
+
+	/* plays Journal frames onto a world; types in the stream must be registered in it, e.g. with component<T>() */
+	class Replay
+	{
+	public:
+		static constexpr Entity NONE = ~Entity { 0 };
+
+		explicit Replay(World &world);
+
+		/* applies every frame in bytes, which holds whole frames; false at the first malformed one or unknown type */
+		bool apply(std::span<const std::byte> bytes);
+
+		[[nodiscard]] Entity entity(Entity recorded) const; /* the replayed counterpart; NONE if there is none */
+
+		[[nodiscard]] Tick tick() const; /* tick of the recording world at the last frame */
+
+	private:
+		bool frame(std::span<const std::byte> payload);
+
+		World &world;
+		std::unordered_map<Entity, Entity> entities; /* recorded -> replayed */
+		std::vector<Archetype *> archetypes;         /* by recorded index; nullptr until announced */
+		Tick last = 0;
+	};
+}
@@ -0,0 +1,139 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include <ncs/types.hpp>
+#include <ncs/archetype/archetypes.hpp>
+#include <ncs/world/world.hpp>
+
+namespace ncs
+{
+	/*
+	 * a component set with default values, captured once; world.instantiate() writes rows of it straight into the
+	 * resolved archetype, replicating each default down its column. a prefab must not outlive its world
+	 */
+	class Prefab
+	{
+	public:
+		explicit Prefab(World &world);
+
+		~Prefab(); /* drops the defaults and the prefab's hold on its shared values */
+
+		Prefab(const Prefab &) = delete;
+
+		Prefab &operator=(const Prefab &) = delete;
+
+		template<typename T>
+		Prefab &set(const T &value); /* default of T for every instance; replaces an earlier one */
+
+		template<typename T>
+		Prefab &set_shared(const T &value); /* every instance shares value; see World::set_shared */
+
+		[[nodiscard]] Archetype *archetype(); /* where instances go; resolved again only after a change */
+
+		void fill(Archetype *archetype, size_t row, size_t count) const; /* defaults into count contiguous rows */
+
+		[[nodiscard]] std::span<const Component> shared() const; /* shared value ids; one hold per instance */
+
+	private:
+		struct Default
+		{
+			Component id = 0;
+			void *data = nullptr;                             /* nullptr for tags */
+			void (*fill)(void *, const void *, size_t) = {}; /* copy-constructs count copies of the second */
+			void (*destroy)(void *) = {};                     /* deletes data */
+		};
+
+		template<typename T>
+		static void replicate(void *dst, const void *src, size_t count);
+
+		void add(Component id); /* marks the archetype stale */
+
+		void release(Default &value);
+
+		World &world;
+		std::vector<Default> defaults;
+		std::vector<Component> ids;         /* every id of the archetype, sorted */
+		std::vector<Component> shared_ids;
+		Archetype *resolved = nullptr;
+	};
+
+	template<typename T>
+	Prefab &Prefab::set(const T &value)
+	{
+		using U = std::remove_cv_t<T>;
+		const Component id = world.component<U>();
+		auto it = std::ranges::find(defaults, id, &Default::id);
+		if (it == defaults.end())
+		{
+			add(id);
+			it = defaults.insert(it, { id });
+		}
+		else
+		{
+			release(*it);
+		}
+
+		if constexpr (!std::is_empty_v<U>)
+		{
+			it->data = new U(value);
+			it->fill = replicate<U>;
+			it->destroy = [](void *ptr)
+			{
+				delete static_cast<U *>(ptr);
+			};
+		}
+
+		return *this;
+	}
+
+	template<typename T>
+	Prefab &Prefab::set_shared(const T &value)
+	{
+		using U = std::remove_cv_t<T>;
+		const Component id = world.retain_shared(value);
+		const Component type = world.component<U>();
+		if (const auto it = std::ranges::find_if(shared_ids, [this, type](const Component c)
+		{
+			return world.shared_type(c) == type;
+		}); it != shared_ids.end())
+		{
+			/* the old value leaves the id list; the new one may well be the same */
+			const Component old = *it;
+			shared_ids.erase(it);
+			std::erase(ids, old);
+			world.release_shared(old);
+		}
+
+		add(world.component<Shared<U> >());
+		add(id);
+		shared_ids.emplace_back(id);
+		return *this;
+	}
+
+	template<typename T>
+	void Prefab::replicate(void *dst, const void *src, const size_t count)
+	{
+		T *to = static_cast<T *>(dst);
+		if constexpr (std::is_trivially_copyable_v<T>)
+		{
+			/* one copy, then the filled prefix doubles; log(count) memcpy calls per column */
+			if (count == 0)
+				return;
+
+			std::memcpy(to, src, sizeof(T));
+			for (size_t done = 1; done < count; done *= 2)
+				std::memcpy(to + done, to, std::min(done, count - done) * sizeof(T));
+		}
+		else
+		{
+			std::uninitialized_fill_n(to, count, *static_cast<const T *>(src));
+		}
+	}
+}
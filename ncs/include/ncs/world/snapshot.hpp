@@ -0,0 +1,52 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <ncs/types.hpp>
+
+namespace ncs
+{
+	/*
+	 * layout of World::save files: a header, one SnapshotArchetype per non-empty archetype, the SnapshotColumn entries
+	 * of every archetype, then the data blocks: generations, handles of live entities without components, then entity
+	 * handles and raw column rows per archetype. offsets count from the start of the file and blocks start on
+	 * Column::ALIGNMENT, so a mapped file can serve as column storage as it is.
+	 * native byte order; components are named by type_key(), never by their per-process id
+	 */
+	constexpr uint32_t SNAPSHOT_MAGIC = 0x5353434E; /* "NCSS" in little-endian order */
+	constexpr uint32_t SNAPSHOT_VERSION = 2;         /* bumped on any layout change; files of another version are refused */
+
+	struct SnapshotHeader
+	{
+		uint32_t magic = SNAPSHOT_MAGIC;
+		uint32_t version = SNAPSHOT_VERSION;
+		uint64_t size = 0;          /* of the whole file; anything else is a truncated or padded file */
+		uint64_t archetypes = 0;    /* SnapshotArchetype entries right after the header */
+		uint64_t entities = 0;      /* rows over all archetypes */
+		uint64_t slots = 0;         /* ids ever handed out */
+		uint64_t generations = 0;   /* offset of one Generation per id; dead ids keep theirs, so stale handles stay stale */
+		uint64_t bare = 0;          /* live entities without components; they are in no archetype */
+		uint64_t bare_entities = 0; /* offset of their handles */
+	};
+
+	struct SnapshotArchetype
+	{
+		uint64_t rows = 0;
+		uint64_t components = 0; /* SnapshotColumn entries at columns, in the archetype's sorted order */
+		uint64_t columns = 0;
+		uint64_t entities = 0;   /* offset of rows handles */
+	};
+
+	struct SnapshotColumn
+	{
+		uint64_t key = 0;    /* type_key() of the component */
+		uint64_t size = 0;   /* bytes per row; 0 for tags */
+		uint64_t offset = 0; /* of rows * size bytes; 0 for tags */
+	};
+
+	static_assert(std::is_trivially_copyable_v<SnapshotHeader> && sizeof(SnapshotHeader) == 64);
+	static_assert(std::is_trivially_copyable_v<SnapshotArchetype> && sizeof(SnapshotArchetype) == 32);
+	static_assert(std::is_trivially_copyable_v<SnapshotColumn> && sizeof(SnapshotColumn) == 24);
+}
@@ -1,28 +1,105 @@
 #pragma once
 
-#include <typeindex>
+#include <algorithm>
+#include <concepts>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string>
 #include <unordered_map>
 #include <vector>
 #include <ncs/types.hpp>
 #include <ncs/archetype/archetypes.hpp>
+#include <ncs/base/typeinfo.hpp>
 #include <ncs/base/utils.hpp>
+#include <ncs/query/rows.hpp>
+#include <ncs/query/terms.hpp>
+#include <ncs/sched/pool.hpp>
+#include <ncs/storage/entities.hpp>
 
 namespace ncs
 {
+	class Journal;
+	class Prefab;
+
+	/* archetypes matching a set of terms; shared by query(), each() and each_chunk() whatever the term order */
+	struct QueryState
+	{
+		/* query()'s type-erased row cache; one per component order, since rows are tuples in that order */
+		struct Rows
+		{
+			const void *type;
+			void *cache;
+			void (*release)(void *);
+		};
+
+		Signature mask;                      /* an archetype matches when (signature & mask) == mask */
+		Signature exclude;                   /* ...holds none of these */
+		std::vector<Signature> any;          /* ...and at least one id of every group; sorted by hash */
+		std::vector<Archetype *> archetypes; /* every matching archetype; patched by create_archetype */
+		std::vector<Rows> rows;
+
+		[[nodiscard]] bool matches(const Signature &signature) const;
+	};
+
+	inline bool QueryState::matches(const Signature &signature) const
+	{
+		if (!signature.contains(mask) || signature.intersects(exclude))
+			return false;
+
+		for (const Signature &group: any)
+		{
+			if (!signature.intersects(group))
+				return false;
+		}
+
+		return true;
+	}
+
 	class World
 	{
 	public:
 		World();
 
+		explicit World(Storage storage); /* storage layout of every archetype in this world */
+
 		~World();
 
 		[[nodiscard]] Entity entity(); /* creates or reuses an entity */
 
+		/* spawns count entities straight into the archetype of Components; init(i, Components &...) fills row i */
+		template<typename... Components, typename Func>
+		std::vector<Entity> spawn_batch(size_t count, Func &&init);
+
+		/* same, with the values copied from equally sized spans */
+		template<typename... Components>
+		std::vector<Entity> spawn_batch(std::type_identity_t<std::span<const Components> >... values);
+
+		/* count entities laid out like prefab, each default replicated down its column; see world/prefab.hpp */
+		std::vector<Entity> instantiate(Prefab &prefab, size_t count);
+
+		/* same; override(i, Components &...) then adjusts row i, e.g. one position per instance. prefab has Components */
+		template<typename... Components, typename Func>
+		std::vector<Entity> instantiate(Prefab &prefab, size_t count, Func &&override);
+
 		void despawn(Entity entity); /* despawn an entity and put them in the pool */
 
+		[[nodiscard]] bool alive(Entity entity) const; /* false once despawned, even if the id was reused */
+
 		template<typename T>
 		World *set(Entity entity, const T &data);
 
+		template<typename T> requires (!std::is_lvalue_reference_v<T>)
+		World *set(Entity entity, T &&data); /* moves into a new slot or move-assigns over the current value */
+
+		/* sets every component with a single move into the final archetype */
+		template<typename... Components> requires (sizeof...(Components) > 1)
+		World *set(Entity entity, const Components &... data);
+
+		/* constructs T from args directly in its column; a current value is replaced by one built from args first */
+		template<typename T, typename... Args>
+		T *emplace(Entity entity, Args &&... args);
+
 		template<typename T>
 		bool has(Entity entity);
 
@@ -32,8 +109,114 @@ namespace ncs
 		template<typename T>
 		World *remove(Entity entity);
 
+		template<typename... Components> requires (sizeof...(Components) > 1)
+		World *remove(Entity entity); /* one move, whichever of Components the entity has */
+
+		/* removes Old, if present, and sets New in one move */
+		template<typename Old, typename New>
+		World *replace(Entity entity, const New &data);
+
+		/*
+		 * (Entity, Components *...) for every matching row, read in place from the per-archetype cache; nothing is copied.
+		 * stale after the next query() of the same components or a structural change
+		 */
+		template<typename... Components>
+		QueryRows<Components...> query();
+
+		/*
+		 * calls func(Entity, args...) or func(args...) for every matching row; a plain T term passes T &.
+		 * With, Without, Optional (T *) and Or terms are resolved when archetypes are matched (see query/terms.hpp)
+		 */
+		template<typename... Components, typename Func>
+		void each(Func &&func);
+
+		/* same; Added<T> and Changed<T> terms only pass rows stamped at or after since */
+		template<typename... Components, typename Func>
+		void each(Tick since, Func &&func);
+
+		/* calls func(span<const Entity>, span<Components>...) once per contiguous block of matching rows; tag spans are empty */
+		template<typename... Components, typename Func>
+		void each_chunk(Func &&func);
+
+		/* each() split into batches of grain rows (rounded to 64) and run on the pool; returns when all are done */
+		template<typename... Components, typename Func>
+		void par_each(ThreadPool &pool, Func &&func, size_t grain = 1024);
+
+		template<typename T>
+		Component component(); /* id of T in this world; registers T on first use */
+
+		/* a single world-wide T outside every archetype; replaces the current one. the reference stays valid until then */
+		template<typename T, typename... Args>
+		T &insert_resource(Args &&... args);
+
+		template<typename T>
+		[[nodiscard]] T *resource() const; /* nullptr if never inserted; a load and a bounds check */
+
+		template<typename T>
+		void remove_resource();
+
+		/*
+		 * relationship pairs; (R, target) is an id of its own, stored in the signature like a tag, so entities sharing
+		 * a parent share an archetype. R is an empty type, e.g. struct ChildOf {}. pairs on a despawned target are removed
+		 */
+		template<typename R>
+		World *add(Entity entity, Entity target);
+
+		template<typename R>
+		World *remove(Entity entity, Entity target);
+
+		template<typename R>
+		bool has(Entity entity, Entity target);
+
+		template<typename R>
+		std::vector<Entity> targets(Entity entity); /* every target of entity's R pairs */
+
+		/* calls func(Entity) for every entity with (R, target), e.g. the children of a parent; served from the reverse index */
+		template<typename R, typename Func>
+		void each_source(Entity target, Func &&func);
+
+		template<typename R>
+		Component pair(Entity target); /* id of (R, target); 0 if no entity has it yet */
+
+		/*
+		 * shared components; entities holding equal values of T hold one copy between them, kept by the world with a
+		 * count of its holders. the value's id sits in the signature like a pair, so its holders share an archetype with
+		 * no column to copy on transitions. read it with get_shared() or a Shared<T> term; T needs operator==
+		 */
+		template<typename T>
+		World *set_shared(Entity entity, const T &value);
+
+		template<typename T>
+		World *remove_shared(Entity entity);
+
+		template<typename T>
+		[[nodiscard]] const T *get_shared(Entity entity) const; /* nullptr if the entity shares no T */
+
+		[[nodiscard]] Tick tick() const; /* every add and write is stamped with the current tick */
+
+		Tick advance(); /* starts a new tick, e.g. once per frame; returns it */
+
+		template<typename T>
+		void mark_changed(Entity entity); /* stamps a write made through get() or each(); set() stamps on its own */
+
+		void mark_changed(Entity entity, Component component);
+
+		/*
+		 * writes every entity and its components to path in the layout of world/snapshot.hpp. false on I/O errors, and
+		 * when a component is not trivially copyable or is a pair or shared value id, which have no stable name
+		 */
+		bool save(const std::string &path) const;
+
+		/*
+		 * restores a save() file into this world, which must have no live entities; handles from the file stay valid.
+		 * every component type in it must be registered first, e.g. with component<T>(). on a bad file nothing is
+		 * touched and false is returned. chunked worlds always copy
+		 */
+		bool load(const std::string &path, Restore mode = Restore::COPY);
+
+		/* resolves ids and the match list up front; iteration over Components afterwards only reads world state */
 		template<typename... Components>
-		std::vector<std::tuple<Entity, Components *...> > query();
+		void prepare();
 
 		/* utils; for testing or debug purposes or actual utils */
 		static Entity encode_entity(uint64_t id, Generation gen); /* binary encoding */
@@ -51,379 +234,999 @@ namespace ncs
 
 		Archetype *find_archetype_without(Archetype *source, Component component);
 
+		/* the archetype of source's components plus add minus remove; no archetypes are created in between */
+		Archetype *find_archetype_delta(Archetype *source, std::span<const Component> add,
+		                                std::span<const Component> remove);
+
 		void move_entity(Entity entity, Record &record, Archetype *destination);
 
+		/*
+		 * moves live entities of source (nullptr for entities without components) to destination in one pass;
+		 * destination grows once and columns are copied one after another; components destination lacks are destroyed
+		 */
+		void move_batch(Archetype *source, Archetype *destination, std::span<const Entity> batch);
+
+		[[nodiscard]] Archetype *archetype_of(Entity entity) const; /* nullptr if dead or without components */
+
+		[[nodiscard]] void *component_ptr(Entity entity, Component component) const; /* raw column slot; nullptr for tags */
+
+		[[nodiscard]] const Record *record_of(Entity entity) const; /* archetype and row; nullptr if dead */
+
+		[[nodiscard]] std::pair<Component, Entity> pair_of(Component id) const; /* relation and target of a pair id */
+
+		/* archetypes currently matching Terms, in creation order; the span is stale once an archetype is created */
+		template<typename... Terms>
+		std::span<Archetype *const> matching();
+
+		/* id of the shared value equal to value, created if none, with one more holder; see release_shared() */
+		template<typename T>
+		Component retain_shared(const T &value);
+
+		void release_shared(Component id); /* drops one holder; the value is destroyed with the last */
+
+		[[nodiscard]] Component shared_type(Component id) const; /* type id of a shared value */
+
+		void record(Journal *journal); /* reports every archetype change and despawn to journal; nullptr stops */
+
+		/*
+		 * moves entity to destination from wherever it is, nullptr or the root meaning no components; new columns are
+		 * left uninitialized, components destination lacks are destroyed
+		 */
+		void place(Entity entity, Archetype *destination);
+
+		[[nodiscard]] std::span<Archetype *const> archetype_table() const; /* every archetype, by index */
+
+		[[nodiscard]] std::span<const TypeInfo> type_table() const; /* by component id; key 0 for ids not registered here */
+
 	private:
+		static constexpr Component DELTA_SEPARATOR = ~Component { 0 }; /* splits added from removed ids in a bundle delta */
+
 		template<typename... Components>
 		struct QueryCache
 		{
-			Archetype *archetype = nullptr; /* strong pointer to the archetype */
-			size_t entity_count = 0;        /* entity count at the time of caching */
-			std::vector<std::tuple<Entity, Components *...> > result;
+			std::vector<QuerySegment<Components...> > segments; /* parallel to QueryState::archetypes */
+			std::vector<size_t> starts;                          /* prefix row counts of segments, then the total */
+
+			static constexpr char type = 0; /* its address tells the caches of different orders apart */
 		};
 
+		/* finds or builds the match list; terms differing only in order share one */
+		QueryState *query_state(const Signature &mask, const Signature &exclude = {}, std::vector<Signature> any = {});
+
+		template<typename... Terms>
+		QueryState *query_terms(); /* query_state() for a list of terms */
+
+		template<typename Term>
+		Component term_cid(); /* id read by column filters; 0 for Or */
+
+		template<typename Term>
+		typename term<Term>::value *term_ptr(Archetype *archetype, size_t row);
+
+		template<typename Term>
+		static auto term_args(typename term<Term>::value *ptr, size_t i); /* what the callback gets, as a tuple */
+
 		template<typename T>
-		Component get_cid()
+		static Component get_cid()
 		{
-			/* use the type */
-			if (const auto it = component_types.find(typeid(T));
-				it != component_types.end())
-			{
-				return it->second;
-			}
+			return type_id<std::remove_cv_t<T> >();
+		}
+
+		/* get_cid() for paths that may create archetypes; they need T's TypeInfo in this world */
+		template<typename T>
+		Component register_cid()
+		{
+			const Component id = get_cid<T>();
+			if (id >= types.size()) [[unlikely]]
+				types.resize(id + 1);
+
+			if (types[id].key == 0) [[unlikely]] /* tags get an entry too; snapshots name them by key */
+				types[id] = TypeInfo::of<std::remove_cv_t<T> >();
 
-			const Component id = next_cid++;
-			component_types[typeid(T)] = id;
-			component_sizes[id] = sizeof(T);
-			if constexpr (!std::is_trivially_destructible_v<T>)
-			{
-				cdtors[id] = [](void *ptr)
-				{
-					static_cast<T *>(ptr)->~T();
-				};
-			}
 			return id;
 		}
 
+		template<typename T>
+		static T *tag()
+		{
+			static T instance {}; /* every row of a tag shares this one */
+			return &instance;
+		}
+
+		template<typename T>
+		static T &element(T *column, const size_t i)
+		{
+			if constexpr (std::is_empty_v<T>)
+				return *column;
+			else
+				return column[i];
+		}
+
 		template<typename T>
 		T *get_component_ptr(Archetype *archetype, const size_t row)
 		{
+			if constexpr (std::is_empty_v<T>)
+				return tag<T>();
+
 			const Component cid = get_cid<T>();
-			const Column &column = archetype->columns.at(cid);
-			return reinterpret_cast<T *>(static_cast<char *>(column.data) + (row * column.size));
+			return static_cast<T *>(archetype->column(cid)->at(row));
 		}
 
+		template<typename... Components>
+		std::pair<Archetype *, size_t> spawn_rows(std::span<Entity> batch); /* ids and rows; columns uninitialized */
+
+		size_t spawn_into(Archetype *archetype, std::span<Entity> batch); /* spawn_rows() for a resolved archetype */
+
+		std::pair<Archetype *, size_t> stamp(Prefab &prefab, std::span<Entity> batch); /* spawn_rows() with defaults */
+
+		template<typename... Terms, typename Func, size_t... I>
+		void each_terms(Tick since, Func &func, std::index_sequence<I...>); /* each() for anything but plain terms */
+
+		[[nodiscard]] static const Column *column_of(const Archetype *archetype, Component component); /* nullptr for tags */
+
+		/* moves the entity into an archetype with component; returns its slot (nullptr for tags) and whether it held one */
+		std::pair<void *, bool> acquire(Entity entity, Record &record, Component component);
+
+		/* acquire() for several components; removed ones the entity has are destroyed. add and remove are disjoint */
+		void transition(Entity entity, Record &record, std::span<const Component> add, std::span<const Component> remove);
+
+		void *touch(const Record &record, Component component); /* stamps a write; returns the slot, nullptr for tags */
+
+		template<typename T>
+		static void write(void *raw_ptr, bool exists, const T &data); /* copies data into a slot; nothing for tags */
+
+		/* detaches a row from its archetype and patches the record of the entity swapped into it */
+		void detach(Archetype *archetype, size_t row);
+
+		/* ids on the stack when a transition misses; longer lists fall back to the heap */
+		static constexpr size_t SCRATCH_COMPONENTS = 64;
+
+		[[nodiscard]] Archetype *lookup_archetype(const Signature &signature) const; /* nullptr if absent */
+
+		Archetype *intern_archetype(std::span<const Component> sorted); /* finds or creates */
+
 		/* archetype management */
-		std::unordered_map<uint64_t, Archetype *> archetypes;
-		std::unordered_map<Entity, Record> entity_records;
-		std::unordered_map<Component, void(*)(void *)> cdtors;                     /* stores component destructor */
-		std::unordered_map<uint64_t, std::pair<void *, void(*)(void *)> > qcaches; /* type-erased query caches */
+		std::vector<Archetype *> archetypes;                        /* dense; an archetype's index is its position */
+		std::unordered_multimap<uint64_t, uint32_t> archetype_ids; /* signature hash -> index; verified on a hit */
+		std::unordered_multimap<uint64_t, QueryState *> qcaches;   /* match lists by term hash; verified on a hit */
+
+		std::vector<TypeInfo> types; /* size and lifetime hooks, indexed by component id */
+
+		struct Resource
+		{
+			void *data = nullptr;
+			void (*destroy)(void *) = {};
+		};
+
+		std::vector<Resource> resources; /* indexed by type id like types; empty slots for anything else */
+
+		struct PairRecord
+		{
+			Component relation = 0;
+			Entity target = 0;                   /* 0 once the id is free */
+			std::vector<Archetype *> archetypes; /* reverse index: every archetype holding this pair */
+		};
+
+		std::vector<PairRecord> pairs;                                /* indexed by pair id without PAIR_FLAG */
+		std::vector<Component> free_pairs;                            /* ids whose target was despawned */
+		std::unordered_map<Entity, std::vector<Component> > targeted; /* target -> pair ids naming it */
 
-		std::unordered_map<Entity, Generation> generations; /* a sparse set to track decoded entity's id */
-		/* maps entity ids to their index poses in the entity pools */
-		std::unordered_map<uint64_t, size_t> entity_indices;
-		std::unordered_map<std::type_index, Component> component_types; /* map component type to component id */
-		std::unordered_map<Component, size_t> component_sizes;          /* stores size of each component type */
+		/* id of (relation, target); with create, a new one is assigned when missing, otherwise 0 */
+		Component pair_id(Component relation, Entity target, bool create);
 
-		std::vector<Entity> entity_pool; /* available ids */
+		void release_pairs(Entity target); /* strips every pair naming target from its holders */
+
+		struct SharedValue
+		{
+			Component type = 0;
+			void *data = nullptr;
+			void (*destroy)(void *) = {};
+			size_t refs = 0; /* entities holding it; the value goes with the last */
+		};
+
+		std::vector<SharedValue> shared;                 /* indexed by value id without SHARED_FLAG */
+		std::vector<Component> free_shared;              /* ids of destroyed values */
+		std::vector<std::vector<Component> > shared_ids; /* live value ids by type id; set_shared() scans them */
+
+		[[nodiscard]] Component shared_id(const Archetype *archetype, Component type) const; /* 0 if none */
+
+		/* load() once the file is mapped and checked; file is writable private memory, adopt keeps columns in it */
+		bool restore(char *file, size_t size, bool adopt);
+
+		struct Mapping
+		{
+			void *data;
+			size_t size;
+		};
+
+		std::vector<Mapping> mappings; /* adopted snapshot files; unmapped in ~World, however many columns still use them */
+
+		Journal *journal = nullptr;
+
+		void moved(Entity entity, Archetype *archetype) const; /* tells the journal, if any */
+
+		EntityTable entities; /* generations, records and the free list in one paged table */
+		Storage storage;      /* layout handed to new archetypes */
 
 		Archetype *root_archetype {}; /* */
-		uint64_t alive_count;         /* the current number of alive & active entity */
-		uint64_t next_eid;            /* next entity id */
-		uint16_t next_cid;            /* next component id */
+		Tick current_tick;
 	};
 
 	template<typename T>
 	World *World::set(const Entity entity, const T &data)
 	{
-		const uint64_t entity_id = get_eid(entity);
-		const Generation gen = get_egen(entity);
+		EntitySlot *slot = entities.find(entity);
+		if (!slot) /* stale or unknown handle; TODO: wrap with debug macro */
+			return this;
 
-		/* if it is valid; TODO: wrap with debug macro */
-		if (const auto it = generations.find(entity_id);
-			it == generations.end() || it->second != gen)
-		{
+		auto [raw_ptr, exists] = acquire(entity, slot->record, register_cid<T>());
+		write(raw_ptr, exists, data);
+		return this;
+	}
+
+	template<typename... Components> requires (sizeof...(Components) > 1)
+	World *World::set(const Entity entity, const Components &... data)
+	{
+		EntitySlot *slot = entities.find(entity);
+		if (!slot)
 			return this;
-		}
 
-		const Component component_id = get_cid<T>();
-		if (const auto record_it = entity_records.find(entity_id); /* check if entity exists in any archetype */
-			record_it == entity_records.end())
-		{
-			/* start checking from the root archetype; entity doesn't exist yet */
-			Archetype *dst = find_archetype_with(root_archetype, component_id);
-			const size_t row = dst->append(entity_id);
+		Record &record = slot->record;
+		const Component cids[] = { register_cid<Components>()... };
+		bool exists[sizeof...(Components)];
+		for (size_t i = 0; i < sizeof...(Components); ++i)
+			exists[i] = record.archetype && record.archetype->has(cids[i]);
+
+		transition(entity, record, cids, {});
 
-			Column &column = dst->columns[component_id];
-			if (column.data == nullptr)
+		size_t i = 0;
+		((write(touch(record, cids[i]), exists[i], data), ++i), ...);
+		return this;
+	}
+
+	template<typename T>
+	void World::write(void *raw_ptr, const bool exists, const T &data)
+	{
+		if constexpr (!std::is_empty_v<T>) /* tags live in the signature only; there is nothing to write */
+		{
+			if constexpr (std::is_trivially_copyable_v<T>)
+				std::memcpy(raw_ptr, &data, sizeof(T));
+			else if constexpr (std::is_copy_assignable_v<T>)
+			{
+				if (exists)
+					*static_cast<T *>(raw_ptr) = data; /* reuses whatever the old value owns */
+				else
+					new(raw_ptr) T(data); /* non-trivial types */
+			}
+			else
 			{
-				column.size = sizeof(T);
-				if (column.capacity < row + 1)
-					column.resize(std::max(size_t { 16 }, row + 1));
+				if (exists)
+					static_cast<T *>(raw_ptr)->~T();
+				new(raw_ptr) T(data);
 			}
+		}
+	}
 
-			if (row >= column.capacity)
-				column.resize(std::max(column.capacity * 2, row + 1));
+	template<typename T> requires (!std::is_lvalue_reference_v<T>)
+	World *World::set(const Entity entity, T &&data)
+	{
+		EntitySlot *slot = entities.find(entity);
+		if (!slot)
+			return this;
 
-			/* copy data */
-			void *raw_ptr = static_cast<char *>(column.data) + (row * column.size);
-			if constexpr (std::is_trivially_copyable_v<T>)
+		auto [raw_ptr, exists] = acquire(entity, slot->record, register_cid<T>());
+		if constexpr (!std::is_empty_v<T>)
+		{
+			if constexpr (std::is_move_assignable_v<T>)
 			{
-				std::memcpy(raw_ptr, &data, sizeof(T));
+				if (exists)
+					*static_cast<T *>(raw_ptr) = std::move(data);
+				else
+					new(raw_ptr) T(std::move(data));
 			}
 			else
 			{
-				new(raw_ptr) T(data); /* non-trivial types */
+				if (exists)
+					static_cast<T *>(raw_ptr)->~T();
+				new(raw_ptr) T(std::move(data));
 			}
+		}
+
+		return this;
+	}
+
+	template<typename T, typename... Args>
+	T *World::emplace(const Entity entity, Args &&... args)
+	{
+		EntitySlot *slot = entities.find(entity);
+		if (!slot)
+			return nullptr;
+
+		auto [raw_ptr, exists] = acquire(entity, slot->record, register_cid<T>());
+		if constexpr (std::is_empty_v<T>)
+		{
+			return tag<T>();
+		}
+		else
+		{
+			if (!exists)
+				return new(raw_ptr) T(std::forward<Args>(args)...);
 
-			entity_records[entity_id] = { dst, row }; /* make a new record */
+			/* args may still refer to the old value; it goes only once the new one is built */
+			T value(std::forward<Args>(args)...);
+			static_cast<T *>(raw_ptr)->~T();
+			return new(raw_ptr) T(std::move(value));
 		}
-		else /* path 2: entity exists in the archetype */
+	}
+
+	template<typename... Components>
+	std::pair<Archetype *, size_t> World::spawn_rows(const std::span<Entity> batch)
+	{
+		/* the final archetype is looked up once; no walk along the graph */
+		Archetype *arch = create_archetype({ register_cid<Components>()... });
+		return { arch, spawn_into(arch, batch) };
+	}
+
+	template<typename... Components, typename Func>
+	std::vector<Entity> World::instantiate(Prefab &prefab, const size_t count, Func &&override)
+	{
+		std::vector<Entity> batch(count);
+		auto [arch, base] = stamp(prefab, batch);
+
+		for (size_t row = base, run; row < base + count; row += run)
 		{
-			Record &record = record_it->second;
-			if (Archetype *current = record.archetype;
-				current->has(component_id)) /* just update the data */
+			run = std::min(arch->run(row), base + count - row);
+			std::apply([&override, row, base, run](Components *... ptrs)
 			{
-				const Column &column = current->columns[component_id];
-				const size_t row = record.row;
+				for (size_t i = 0; i < run; ++i)
+					override(row - base + i, element(ptrs, i)...);
+			}, std::tuple<Components *...> { get_component_ptr<Components>(arch, row)... });
+		}
 
-				if (row >= column.capacity)
-				{
-					auto &mutable_column = const_cast<Column &>(column);
-					mutable_column.resize(std::max(column.capacity * 2, row + 1));
-				}
+		return batch;
+	}
 
-				void *raw_ptr = static_cast<char *>(column.data) + (row * column.size);
-				if constexpr (std::is_trivially_copyable_v<T>)
-				{
-					std::memcpy(raw_ptr, &data, sizeof(T));
-				}
-				else
-				{
-					static_cast<T *>(raw_ptr)->~T();
-					new(raw_ptr) T(data);
-				}
+	template<typename... Components, typename Func>
+	std::vector<Entity> World::spawn_batch(const size_t count, Func &&init)
+	{
+		static_assert(sizeof...(Components) > 0, "spawn_batch needs at least one component");
 
-				current->flags |= DirtyFlags::UPDATED;
-			}
-			else
+		std::vector<Entity> batch(count);
+		auto [arch, base] = spawn_rows<Components...>(batch);
+
+		for (size_t row = base, run; row < base + count; row += run)
+		{
+			run = std::min(arch->run(row), base + count - row);
+			std::tuple<Components *...> columns = { get_component_ptr<Components>(arch, row)... };
+
+			/* value-initialize a whole run per column, then hand the rows out */
+			std::apply([run](Components *... ptrs)
 			{
-				Archetype *destination = find_archetype_with(current, component_id);
-				if (Column &column = destination->columns[component_id];
-					column.data == nullptr) /* setup col if not */
+				([&]
 				{
-					column.size = sizeof(T);
-					column.resize(std::max(size_t { 16 }, destination->entities.size()));
-				}
-				move_entity(entity_id, record, destination);
+					if constexpr (!std::is_empty_v<Components>)
+						std::uninitialized_value_construct_n(ptrs, run);
+				}(), ...);
+			}, columns);
 
-				const size_t row = record.row;
-				const Column &updated_column = destination->columns[component_id];
-				if (row >= updated_column.capacity)
-				{
-					auto &mutable_column = const_cast<Column &>(updated_column);
-					mutable_column.resize(std::max(updated_column.capacity * 2, row + 1));
-				}
+			std::apply([&init, row, base, run](Components *... ptrs)
+			{
+				for (size_t i = 0; i < run; ++i)
+					init(row - base + i, element(ptrs, i)...);
+			}, columns);
+		}
 
-				/* set the transferred data in the new archetype */
-				void *raw_ptr = static_cast<char *>(updated_column.data) + (row * updated_column.size);
-				if constexpr (std::is_trivially_copyable_v<T>)
-				{
-					std::memcpy(raw_ptr, &data, sizeof(T));
-				}
+		return batch;
+	}
+
+	template<typename... Components>
+	std::vector<Entity> World::spawn_batch(std::type_identity_t<std::span<const Components> >... values)
+	{
+		static_assert(sizeof...(Components) > 0, "spawn_batch needs at least one component");
+
+		const size_t count = std::get<0>(std::tie(values...)).size();
+		if (((values.size() != count) || ...))
+			return {};
+
+		std::vector<Entity> batch(count);
+		auto [arch, base] = spawn_rows<Components...>(batch);
+
+		/* one copy per column and run; a contiguous archetype has a single run */
+		for (size_t row = base, run; row < base + count; row += run)
+		{
+			run = std::min(arch->run(row), base + count - row);
+			const size_t offset = row - base;
+			([&]
+			{
+				Components *dst = get_component_ptr<Components>(arch, row);
+				if constexpr (std::is_empty_v<Components>)
+					return;
+				else if constexpr (std::is_trivially_copyable_v<Components>)
+					std::memcpy(dst, values.data() + offset, run * sizeof(Components));
 				else
-				{
-					new(raw_ptr) T(data);
-				}
-			}
+					std::uninitialized_copy_n(values.data() + offset, run, dst);
+			}(), ...);
 		}
 
-		return this;
+		return batch;
 	}
 
 	template<typename T>
 	T *World::get(Entity entity)
 	{
-		const uint64_t entity_id = get_eid(entity);
-		const Generation gen = get_egen(entity);
-		if (const auto it = generations.find(entity_id);
-			it == generations.end() || it->second != gen)
-		{
+		const EntitySlot *slot = entities.find(entity);
+		if (!slot || slot->record.archetype == nullptr)
 			return nullptr;
-		}
 
 		const Component component_id = get_cid<T>();
-		const auto it = entity_records.find(entity_id);
-		if (it == entity_records.end())
-			return nullptr;
-
-		auto &[archetype, row] = it->second;
-		Archetype *arch = archetype;
+		auto &[arch, row] = slot->record;
 		if (!arch->has(component_id))
 			return nullptr;
 
-		const Column &column = arch->columns[component_id];
-		return reinterpret_cast<T *>(static_cast<char *>(column.data) + (row * column.size));
+		if constexpr (std::is_empty_v<T>)
+			return tag<T>();
+
+		return static_cast<T *>(arch->column(component_id)->at(row));
 	}
 
 	template<typename T>
 	bool World::has(const Entity entity)
 	{
-		const uint64_t entity_id = get_eid(entity);
-		const Generation gen = get_egen(entity);
-		if (const auto it = generations.find(entity_id);
-			it == generations.end() || it->second != gen)
-		{
+		const EntitySlot *slot = entities.find(entity);
+		if (!slot || slot->record.archetype == nullptr)
 			return false;
-		}
 
-		const Component component_id = get_cid<T>();
-		const auto it = entity_records.find(entity_id);
-		if (it == entity_records.end())
-			return false;
-
-		Archetype *archetype = it->second.archetype;
-		return archetype->has(component_id);
+		return slot->record.archetype->has(get_cid<T>());
 	}
 
 	template<typename T>
 	World *World::remove(const Entity entity)
 	{
-		const uint64_t entity_id = get_eid(entity);
-		const Generation gen = get_egen(entity);
-		if (const auto it = generations.find(entity_id);
-			it == generations.end() || it->second != gen)
-		{
+		EntitySlot *slot = entities.find(entity);
+		if (!slot || slot->record.archetype == nullptr)
 			return this;
-		}
 
 		const Component component_id = get_cid<T>();
-		const auto it = entity_records.find(entity_id);
-		if (it == entity_records.end())
-			return this;
-
-		Record &record = it->second;
+		Record &record = slot->record;
 		Archetype *current = record.archetype;
 		if (!current->has(component_id))
 			return this;
 
-		if constexpr (!std::is_trivially_destructible_v<T>) /* destroy if not trivial type */
+		if constexpr (!std::is_trivially_destructible_v<T> && !std::is_empty_v<T>) /* destroy if not trivial type */
 		{
 			if (T *component_ptr = get<T>(entity))
 				component_ptr->~T();
 		}
 
 		Archetype *dst = find_archetype_without(current, component_id);
-		move_entity(entity_id, record, dst);
+		move_entity(entity, record, dst);
 		return this;
 	}
 
-	template<typename... Components>
-	std::vector<std::tuple<Entity, Components *...> > World::query()
+	template<typename... Components> requires (sizeof...(Components) > 1)
+	World *World::remove(const Entity entity)
+	{
+		EntitySlot *slot = entities.find(entity);
+		if (!slot || slot->record.archetype == nullptr)
+			return this;
+
+		const Component cids[] = { get_cid<Components>()... };
+		transition(entity, slot->record, {}, cids);
+		return this;
+	}
+
+	template<typename Old, typename New>
+	World *World::replace(const Entity entity, const New &data)
 	{
-		const std::vector<Component> cids = { get_cid<Components>()... };
-		const uint64_t qhash = archash(cids);
+		static_assert(!std::is_same_v<std::remove_cv_t<Old>, std::remove_cv_t<New> >, "use set() to overwrite a component");
 
-		auto cache_it = qcaches.find(qhash);
-		QueryCache<Components...> *cache = nullptr;
+		EntitySlot *slot = entities.find(entity);
+		if (!slot)
+			return this;
 
-		if (cache_it != qcaches.end())
-		{
-			cache = static_cast<QueryCache<Components...> *>(cache_it->second.first);
-			if (cache->archetype && cache->entity_count == cache->archetype->entity_count &&
-			    !has_flag(cache->archetype->flags, DirtyFlags::ADDED | DirtyFlags::REMOVED | DirtyFlags::UPDATED))
+		Record &record = slot->record;
+		const Component removed = get_cid<Old>();
+		const Component added = register_cid<New>();
+		const bool exists = record.archetype && record.archetype->has(added);
+
+		transition(entity, record, { &added, 1 }, { &removed, 1 });
+		write(touch(record, added), exists, data);
+		return this;
+	}
+
+	template<typename T, typename... Args>
+	T &World::insert_resource(Args &&... args)
+	{
+		const Component id = get_cid<T>();
+		if (id >= resources.size())
+			resources.resize(id + 1);
+
+		auto *value = new std::remove_cv_t<T>(std::forward<Args>(args)...); /* args may still refer to the old one */
+		remove_resource<T>();
+		resources[id] = {
+			value,
+			[](void *ptr)
 			{
-				return cache->result;
+				delete static_cast<std::remove_cv_t<T> *>(ptr);
 			}
+		};
+		return *value;
+	}
 
-			if (cache->archetype)
-			{
-				if (has_flag(cache->archetype->flags, DirtyFlags::ADDED) &&
-				    !has_flag(cache->archetype->flags, DirtyFlags::REMOVED | DirtyFlags::UPDATED))
-				{
-					/* append the new entities */
-					for (size_t i = cache->entity_count; i < cache->archetype->entity_count; ++i)
-					{
-						Entity entity_id = cache->archetype->entities[i];
-						const auto gen_it = generations.find(entity_id);
-						if (gen_it == generations.end())
-							continue;
+	template<typename T>
+	T *World::resource() const
+	{
+		const Component id = get_cid<T>();
+		return id < resources.size() ? static_cast<T *>(resources[id].data) : nullptr;
+	}
 
-						Entity encoded_entity = encode_entity(entity_id, gen_it->second);
-						cache->result.emplace_back(std::make_tuple(
-							encoded_entity,
-							get_component_ptr<Components>(cache->archetype, i)...
-						));
-					}
-					cache->entity_count = cache->archetype->entity_count;
-					cache->archetype->flags = static_cast<DirtyFlags>(
-						static_cast<uint64_t>(cache->archetype->flags) &
-						~static_cast<uint64_t>(DirtyFlags::ADDED) /* reset the flag */
-					);
-					return cache->result;
-				}
+	template<typename T>
+	void World::remove_resource()
+	{
+		const Component id = get_cid<T>();
+		if (id >= resources.size() || !resources[id].data)
+			return;
+
+		resources[id].destroy(resources[id].data);
+		resources[id] = {};
+	}
+
+	template<typename R>
+	World *World::add(const Entity entity, const Entity target)
+	{
+		static_assert(std::is_empty_v<R>, "relations carry no data");
+
+		EntitySlot *slot = entities.find(entity);
+		if (!slot || !alive(target))
+			return this;
+
+		acquire(entity, slot->record, pair_id(register_cid<R>(), target, true));
+		return this;
+	}
+
+	template<typename R>
+	World *World::remove(const Entity entity, const Entity target)
+	{
+		EntitySlot *slot = entities.find(entity);
+		if (!slot || slot->record.archetype == nullptr)
+			return this;
+
+		if (const Component id = pair_id(get_cid<R>(), target, false))
+			transition(entity, slot->record, {}, { &id, 1 });
+		return this;
+	}
+
+	template<typename R>
+	bool World::has(const Entity entity, const Entity target)
+	{
+		const Component id = pair_id(get_cid<R>(), target, false);
+		const Archetype *archetype = archetype_of(entity);
+		return id && archetype && archetype->has(id);
+	}
+
+	template<typename R>
+	std::vector<Entity> World::targets(const Entity entity)
+	{
+		std::vector<Entity> result;
+		const Archetype *archetype = archetype_of(entity);
+		if (!archetype)
+			return result;
+
+		/* pair ids sort after every type id, so they sit at the end of the component list */
+		const Component relation = get_cid<R>();
+		for (auto it = std::ranges::lower_bound(archetype->components, PAIR_FLAG); it != archetype->components.end(); ++it)
+		{
+			if (const PairRecord &record = pairs[*it & ~PAIR_FLAG];
+				record.relation == relation)
+				result.emplace_back(record.target);
+		}
+
+		return result;
+	}
+
+	template<typename R, typename Func>
+	void World::each_source(const Entity target, Func &&func)
+	{
+		const Component id = pair_id(get_cid<R>(), target, false);
+		if (!id)
+			return;
+
+		for (const Archetype *arch: pairs[id & ~PAIR_FLAG].archetypes)
+		{
+			for (size_t row = 0; row < arch->entity_count; ++row)
+				func(*arch->entity_at(row));
+		}
+	}
+
+	template<typename R>
+	Component World::pair(const Entity target)
+	{
+		return pair_id(get_cid<R>(), target, false);
+	}
+
+	template<typename T>
+	World *World::set_shared(const Entity entity, const T &value)
+	{
+		using U = std::remove_cv_t<T>;
+		EntitySlot *slot = entities.find(entity);
+		if (!slot)
+			return this;
 
-				if (has_flag(cache->archetype->flags, DirtyFlags::REMOVED) &&
-				    !has_flag(cache->archetype->flags, DirtyFlags::ADDED | DirtyFlags::UPDATED))
+		Record &record = slot->record;
+		const Component id = retain_shared(value);
+		const Component old = record.archetype ? shared_id(record.archetype, get_cid<U>()) : 0;
+		if (old == id)
+		{
+			release_shared(id);
+			return this;
+		}
+
+		/* the tag lets queries match every value of T; the value id picks the archetype */
+		const Component added[] = { register_cid<Shared<U> >(), id };
+		transition(entity, record, added, old ? std::span(&old, 1) : std::span<const Component>());
+		if (old)
+			release_shared(old);
+		return this;
+	}
+
+	template<typename T>
+	World *World::remove_shared(const Entity entity)
+	{
+		EntitySlot *slot = entities.find(entity);
+		if (!slot || slot->record.archetype == nullptr)
+			return this;
+
+		const Component id = shared_id(slot->record.archetype, get_cid<T>());
+		if (!id)
+			return this;
+
+		const Component removed[] = { get_cid<Shared<std::remove_cv_t<T> > >(), id };
+		transition(entity, slot->record, {}, removed);
+		release_shared(id);
+		return this;
+	}
+
+	template<typename T>
+	const T *World::get_shared(const Entity entity) const
+	{
+		const Archetype *archetype = archetype_of(entity);
+		const Component id = archetype ? shared_id(archetype, get_cid<T>()) : 0;
+		return id ? static_cast<const T *>(shared[id & ~SHARED_FLAG].data) : nullptr;
+	}
+
+	template<typename T>
+	Component World::retain_shared(const T &value)
+	{
+		using U = std::remove_cv_t<T>;
+		static_assert(std::equality_comparable<U>, "shared values are told apart with ==");
+
+		/* a type has a handful of distinct shared values; a scan beats hashing them */
+		const Component type = get_cid<U>();
+		if (type < shared_ids.size())
+		{
+			for (const Component id: shared_ids[type])
+			{
+				if (SharedValue &held = shared[id & ~SHARED_FLAG];
+					*static_cast<const U *>(held.data) == value)
 				{
-					/* filter out non-existent entities; entities were removed */
-					auto &result = cache->result;
-					result.erase(
-						std::remove_if(result.begin(), result.end(),
-						               [this, cache](const auto &tuple)
-						               {
-							               Entity encoded_entity = std::get<0>(tuple);
-							               uint64_t entity_id = get_eid(encoded_entity);
-							               return cache->archetype->entity_rows.find(entity_id) == cache->archetype->
-							                      entity_rows.end();
-						               }),
-						result.end()
-					);
-					cache->entity_count = cache->archetype->entity_count;
-					cache->archetype->flags = static_cast<DirtyFlags>(
-						static_cast<uint64_t>(cache->archetype->flags) &
-						~static_cast<uint64_t>(DirtyFlags::REMOVED) /* reset the flag */
-					);
-					return cache->result;
+					++held.refs;
+					return id;
 				}
-				if (has_flag(cache->archetype->flags, DirtyFlags::UPDATED))
+			}
+		}
+		else
+		{
+			shared_ids.resize(type + 1);
+		}
+
+		Component id;
+		if (!free_shared.empty())
+		{
+			/* archetypes holding a freed id are empty, as with pairs */
+			id = free_shared.back();
+			free_shared.pop_back();
+		}
+		else
+		{
+			id = static_cast<Component>(shared.size()) | SHARED_FLAG;
+			shared.emplace_back();
+		}
+
+		shared[id & ~SHARED_FLAG] = {
+			type,
+			new U(value),
+			[](void *ptr)
+			{
+				delete static_cast<U *>(ptr);
+			},
+			1
+		};
+		shared_ids[type].emplace_back(id);
+		return id;
+	}
+
+	template<typename T>
+	Component World::component()
+	{
+		return register_cid<std::remove_cv_t<T> >();
+	}
+
+	template<typename T>
+	void World::mark_changed(const Entity entity)
+	{
+		mark_changed(entity, get_cid<std::remove_cv_t<T> >());
+	}
+
+	template<typename... Components>
+	void World::prepare()
+	{
+		query_terms<Components...>();
+	}
+
+	template<typename... Terms>
+	std::span<Archetype *const> World::matching()
+	{
+		return query_terms<Terms...>()->archetypes;
+	}
+
+	template<typename... Terms>
+	QueryState *World::query_terms()
+	{
+		/* masks are built in place; only Or groups touch the heap */
+		Signature require, exclude;
+		std::vector<Signature> any;
+		([&]
+		{
+			using T = term<Terms>;
+			if constexpr (T::kind == TermKind::ANY)
+			{
+				Signature &group = any.emplace_back();
+				[&group]<typename... Ts>(std::type_identity<std::tuple<Ts...> >)
 				{
-					cache->archetype->flags = static_cast<DirtyFlags>(
-						static_cast<uint64_t>(cache->archetype->flags) &
-						~static_cast<uint64_t>(DirtyFlags::UPDATED)
-					);
-				}
+					(group.set(get_cid<Ts>()), ...);
+				}(std::type_identity<typename T::components>());
+			}
+			else
+			{
+				const Component cid = get_cid<typename T::component>(); /* a lookup only; optional ids go into no signature */
+				if constexpr (T::kind == TermKind::REQUIRE)
+					require.set(cid);
+				else if constexpr (T::kind == TermKind::EXCLUDE)
+					exclude.set(cid);
 			}
+		}(), ...);
+
+		return query_state(require, exclude, std::move(any));
+	}
+
+	template<typename Term>
+	Component World::term_cid()
+	{
+		if constexpr (term<Term>::kind == TermKind::ANY)
+			return 0;
+		else
+			return get_cid<typename term<Term>::component>();
+	}
+
+	template<typename Term>
+	typename term<Term>::value *World::term_ptr(Archetype *archetype, const size_t row)
+	{
+		using T = term<Term>;
+		if constexpr (std::is_void_v<typename T::value>)
+			return nullptr;
+		else if constexpr (T::shared) /* one lookup per run; matching archetypes always hold a value */
+		{
+			const Component id = shared_id(archetype, get_cid<typename T::value>());
+			return static_cast<typename T::value *>(shared[id & ~SHARED_FLAG].data);
 		}
+		else if constexpr (T::kind == TermKind::OPTIONAL)
+			return archetype->has(get_cid<typename T::component>())
+				       ? get_component_ptr<typename T::component>(archetype, row)
+				       : nullptr;
+		else
+			return get_component_ptr<typename T::component>(archetype, row);
+	}
+
+	template<typename Term>
+	auto World::term_args(typename term<Term>::value *ptr, const size_t i)
+	{
+		using T = term<Term>;
+		if constexpr (std::is_void_v<typename T::value>)
+			return std::tuple<>();
+		else if constexpr (T::shared)
+			return std::tuple<typename T::value &>(*ptr); /* the same value for every row */
+		else if constexpr (T::kind == TermKind::OPTIONAL)
+			return std::tuple<typename T::value *>(ptr ? &element(ptr, i) : nullptr);
 		else
+			return std::tuple<typename T::value &>(element(ptr, i));
+	}
+
+	template<typename... Components>
+	QueryRows<Components...> World::query()
+	{
+		static_assert(all_plain_v<Components...>, "query() takes plain components; use each() for other terms");
+
+		using Cache = QueryCache<Components...>;
+		QueryState *state = query_terms<Components...>();
+		auto it = std::ranges::find(state->rows, &Cache::type, &QueryState::Rows::type);
+		if (it == state->rows.end())
 		{
-			cache = new QueryCache<Components...>();
-			qcaches[qhash] = {
-				cache,
+			state->rows.push_back({
+				&Cache::type,
+				new Cache(),
 				[](void *ptr)
 				{
-					delete static_cast<QueryCache<Components...> *>(ptr);
+					delete static_cast<Cache *>(ptr);
 				}
-			};
+			});
+			it = state->rows.end() - 1;
+		}
+
+		auto *cache = static_cast<Cache *>(it->cache);
+		cache->segments.resize(state->archetypes.size());
+
+		/* only archetypes whose version moved are rebuilt; steady state costs one compare per archetype */
+		auto changed = false;
+		for (size_t i = 0; i < state->archetypes.size(); ++i)
+		{
+			Archetype *arch = state->archetypes[i];
+			auto &segment = cache->segments[i];
+			if (segment.version == arch->version)
+				continue;
+
+			segment.rows.clear();
+			segment.rows.reserve(arch->entity_count);
+			for (size_t row = 0; row < arch->entity_count; ++row)
+			{
+				segment.rows.emplace_back(std::make_tuple(
+					*arch->entity_at(row),
+					get_component_ptr<Components>(arch, row)...
+				));
+			}
+
+			segment.version = arch->version;
+			changed = true;
+		}
+
+		/* offsets only; the rows stay in their segments */
+		if (changed || cache->starts.size() != cache->segments.size() + 1)
+		{
+			cache->starts.resize(cache->segments.size() + 1);
+			cache->starts[0] = 0;
+			for (size_t i = 0; i < cache->segments.size(); ++i)
+				cache->starts[i + 1] = cache->starts[i] + cache->segments[i].rows.size();
 		}
 
-		/* clear existing results if this is a cache rebuild */
-		std::vector<std::tuple<Entity, Components *...>>().swap(cache->result);
+		return { cache->segments, cache->starts };
+	}
+
+	template<typename... Components, typename Func>
+	void World::each_chunk(Func &&func)
+	{
+		static_assert(sizeof...(Components) > 0, "each_chunk needs at least one component");
+		static_assert(all_plain_v<Components...>, "each_chunk() takes plain components; use each() for other terms");
 
-		/* populate the query */
-		for (const auto &[hash, arch]: archetypes)
+		/* no per-entity tuples; columns are handed out as they sit in the archetype */
+		const QueryState *state = query_terms<Components...>();
+		for (Archetype *arch: state->archetypes)
 		{
-			auto valid = true;
-			for (const Component cid: cids)
+			/* one call per archetype; chunked archetypes yield one call per chunk */
+			for (size_t row = 0, run = 0; row < arch->entity_count; row += run)
 			{
-				if (!arch->has(cid))
-				{
-					valid = false;
-					break;
-				}
+				run = arch->run(row);
+				func(std::span<const Entity>(arch->entity_at(row), run),
+				     std::span<Components>(get_component_ptr<std::remove_cv_t<Components> >(arch, row),
+				                           std::is_empty_v<Components> ? 0 : run)...);
 			}
+		}
+	}
+
+	template<typename... Components, typename Func>
+	void World::each(Func &&func)
+	{
+		each<Components...>(current_tick, std::forward<Func>(func));
+	}
 
-			if (!valid)
+	template<typename... Terms, typename Func, size_t... I>
+	void World::each_terms(const Tick since, Func &func, std::index_sequence<I...>)
+	{
+		const QueryState *state = query_terms<Terms...>(); /* excluded archetypes are never in the list */
+		const Component cids[] = { term_cid<Terms>()... };
+		for (Archetype *arch: state->archetypes)
+		{
+			/* an archetype none of whose filtered columns moved since the tick is never walked */
+			const Column *columns[] = { column_of(arch, cids[I])... };
+			if (!(term<Terms>::column(columns[I], since) && ...))
 				continue;
 
-			/* patch & cache the result */
-			cache->archetype = arch;
-			cache->entity_count = arch->entity_count;
-			for (size_t i = 0; i < arch->entity_count; ++i)
+			for (size_t row = 0, run = 0; row < arch->entity_count; row += run)
 			{
-				Entity entity_id = arch->entities[i];
-				const auto gen_it = generations.find(entity_id);
-				if (gen_it == generations.end())
-					continue;
-
-				Entity encoded_entity = encode_entity(entity_id, gen_it->second);
-				cache->result.emplace_back(std::make_tuple(
-					encoded_entity,
-					get_component_ptr<Components>(arch, i)...
-				));
+				run = arch->run(row);
+				const std::tuple<typename term<Terms>::value *...> ptrs = { term_ptr<Terms>(arch, row)... };
+				for (size_t i = 0; i < run; ++i)
+				{
+					if constexpr ((term<Terms>::filtered || ...))
+					{
+						if (!(term<Terms>::row(columns[I], row + i, since) && ...))
+							continue;
+					}
+
+					std::apply([&func, entity = *arch->entity_at(row + i)](auto &&... args)
+					{
+						if constexpr (std::is_invocable_v<Func &, Entity, decltype(args)...>)
+							func(entity, args...);
+						else
+							func(args...);
+					}, std::tuple_cat(term_args<Terms>(std::get<I>(ptrs), i)...));
+				}
 			}
 		}
+	}
+
+	template<typename... Components, typename Func>
+	void World::each(const Tick since, Func &&func)
+	{
+		if constexpr (!all_plain_v<Components...>)
+		{
+			each_terms<Components...>(since, func, std::index_sequence_for<Components...>());
+		}
+		else
+		{
+			/* nothing to filter; whole runs straight from each_chunk */
+			each_chunk<Components...>([&func](const std::span<const Entity> entities,
+			                                  const std::span<Components>... columns)
+			{
+				for (size_t i = 0; i < entities.size(); ++i)
+				{
+					if constexpr (std::is_invocable_v<Func &, Entity, Components &...>)
+						func(entities[i], element(columns.data(), i)...);
+					else
+						func(element(columns.data(), i)...);
+				}
+			});
+		}
+	}
+
+	template<typename... Components, typename Func>
+	void World::par_each(ThreadPool &pool, Func &&func, size_t grain)
+	{
+		struct Batch
+		{
+			const Entity *entities;
+			size_t count;
+			std::tuple<Components *...> columns;
+		};
+
+		/* whole cache lines of every column per batch; batches never share a line */
+		grain = (std::max(grain, size_t { 1 }) + 63) & ~size_t { 63 };
+
+		/* batches are cut on the calling thread so workers never touch world state */
+		std::vector<Batch> batches;
+		each_chunk<Components...>([&batches, grain](const std::span<const Entity> entities,
+		                                            const std::span<Components>... columns)
+		{
+			for (size_t begin = 0; begin < entities.size(); begin += grain)
+			{
+				batches.push_back({
+					entities.data() + begin,
+					std::min(grain, entities.size() - begin),
+					{ (std::is_empty_v<Components> ? columns.data() : columns.data() + begin)... }
+				});
+			}
+		});
 
-		return cache->result;
+		pool.run(batches.size(), [&batches, &func](const size_t index)
+		{
+			const Batch &batch = batches[index];
+			std::apply([&batch, &func](Components *... columns)
+			{
+				for (size_t i = 0; i < batch.count; ++i)
+				{
+					if constexpr (std::is_invocable_v<Func &, Entity, Components &...>)
+						func(batch.entities[i], element(columns, i)...);
+					else
+						func(element(columns, i)...);
+				}
+			}, batch.columns);
+		});
 	}
 }
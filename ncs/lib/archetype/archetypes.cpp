@@ -1,77 +1,196 @@
 /* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
 
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 #include <ncs/archetype/archetypes.hpp>
 
 namespace ncs
 {
+	void EdgeTable::insert(const Component c, const uint32_t to)
+	{
+		if ((count + 1) * 2 > slots.size())
+		{
+			std::vector<Slot> old = std::move(slots);
+			slots.assign(old.empty() ? 8 : old.size() * 2, {});
+			count = 0;
+			for (const Slot &slot: old)
+			{
+				if (slot.to != NONE)
+					insert(slot.id, slot.to);
+			}
+		}
+
+		const size_t mask = slots.size() - 1;
+		size_t i = bucket(c) & mask;
+		while (slots[i].to != NONE && slots[i].id != c)
+			i = (i + 1) & mask;
+
+		count += slots[i].to == NONE;
+		slots[i] = { c, to };
+	}
+
+	Archetype::~Archetype()
+	{
+		for (void *chunk: chunks)
+			std::free(chunk);
+	}
+
 	size_t Archetype::append(const Entity entity)
 	{
+		if (entity_count == capacity)
+			reserve(entity_count + 1);
+
 		const size_t row = entity_count++;
-		if (row >= entities.size())
+		*entity_at(row) = entity;
+		flags |= DirtyFlags::ADDED;
+		++version;
+		return row;
+	}
+
+	size_t Archetype::append(const std::span<const Entity> batch)
+	{
+		const size_t base = entity_count;
+		reserve(base + batch.size());
+
+		entity_count += batch.size();
+		for (size_t i = 0, count = 0; i < batch.size(); i += count)
 		{
-			const size_t newsz = entities.empty() ? 16 : entities.size() * 2;
-			entities.resize(newsz);
-			for (auto &[comp_id, column]: columns)
-				column.resize(newsz);
+			count = run(base + i);
+			std::copy_n(batch.begin() + static_cast<std::ptrdiff_t>(i), count, entity_at(base + i));
 		}
 
-		entities[row] = entity;
-		entity_rows[entity] = row;
 		flags |= DirtyFlags::ADDED;
-		return row;
+		++version;
+		return base;
 	}
 
-	bool Archetype::has(const Component c) const
+	void Archetype::reserve(const size_t rows)
 	{
-		return std::ranges::find(components, c) != components.end();
+		if (rows <= capacity)
+			return;
+
+		if (storage == Storage::CHUNKED)
+		{
+			/* one chunk at a time; existing rows, their handles and their ticks stay where they are */
+			while (capacity < rows)
+				grow_chunk();
+			return;
+		}
+
+		const size_t newsz = std::bit_ceil(std::max(rows, size_t { 16 }));
+		entities.resize(newsz);
+		for (Column &column: columns)
+		{
+			column.resize(newsz, entity_count);
+			column.added_ticks.resize(newsz);
+			column.changed_ticks.resize(newsz);
+		}
+		capacity = newsz;
 	}
 
-	void Archetype::remove(const Entity entity)
+	void Archetype::remove(const size_t row)
 	{
-		/* entity here is expected to be raw id */
-		const auto it = entity_rows.find(entity);
-		if (it == entity_rows.end())
+		if (row >= entity_count)
 			return;
 
-		const size_t row = it->second;
 		if (const size_t last_row = entity_count - 1;
 			row != last_row)
 		{
 			/* move the last entity to this row; O(1) for appending last */
-			const Entity last_entity = entities[last_row];
-			for (auto &[comp_id, column]: columns)
+			for (Column &column: columns)
 			{
-				memcpy(
-					static_cast<char *>(column.data) + (row * column.size),
-					static_cast<char *>(column.data) + (last_row * column.size),
-					column.size
-				);
+				column.relocate(column.at(row), column.at(last_row));
+				column.copy_ticks(row, column, last_row);
 			}
 
-			entities[row] = last_entity;
-			entity_rows[last_entity] = row;
+			*entity_at(row) = *entity_at(last_row);
 		}
 
 		/* clear the last entity*/
 		entity_count--;
-		entity_rows.erase(entity);
 		flags |= DirtyFlags::REMOVED; /* mark as removed */
+		++version;
 	}
 
 	void Archetype::move(const size_t row, Archetype *dest, const Entity entity)
 	{
 		const size_t dest_row = dest->append(entity);
-		for (Component comp_id: components)
+		for (const Column &c1: columns)
 		{
-			if (dest->has(comp_id))
+			if (Column *c2 = dest->column(c1.id))
 			{
-				const auto& c1 = columns[comp_id];
-				const auto& c2 = dest->columns[comp_id];
-				memcpy(static_cast<char *>(c2.data) + (dest_row * c1.size),
-					static_cast<char *>(c1.data) + row * c1.size, c1.size);
+				c2->relocate(c2->at(dest_row), c1.at(row));
+				c2->copy_ticks(dest_row, c1, row);
 			}
 		}
 
-		remove(entity);
+		remove(row);
+	}
+
+	Column &Archetype::add_column(const Component c)
+	{
+		if (Column *existing = column(c))
+			return *existing;
+
+		if (c >= slots.size())
+			slots.resize(c + 1, NO_COLUMN);
+		slots[c] = static_cast<uint16_t>(columns.size());
+
+		Column &column = columns.emplace_back();
+		column.id = c;
+		return column;
+	}
+
+	void Archetype::grow_chunk()
+	{
+		constexpr size_t align = Column::ALIGNMENT;
+
+		if (chunk_rows == 0)
+		{
+			/* largest power of two rows whose handles, columns and ticks fit in one chunk */
+			size_t row_bytes = sizeof(Entity);
+			for (const Column &column: columns)
+				row_bytes += column.size + 2 * sizeof(Tick);
+
+			chunk_rows = 1;
+			while (row_bytes * chunk_rows * 2 <= CHUNK_SIZE && chunk_rows < CHUNK_SIZE)
+				chunk_rows *= 2;
+
+			chunk_shift = std::countr_zero(chunk_rows);
+			for (Column &column: columns)
+				column.block_shift = chunk_shift;
+		}
+
+		/*
+		 * handles first, then the columns in component order, each block followed by its added and changed ticks.
+		 * every block starts on its own cache line; tags take no space
+		 */
+		const auto aligned = [](const size_t bytes) { return (bytes + align - 1) & ~(align - 1); };
+		const size_t handles = aligned(sizeof(Entity) * chunk_rows);
+		const size_t ticks = aligned(2 * sizeof(Tick) * chunk_rows);
+
+		size_t chunk_bytes = handles;
+		for (const Column &column: columns)
+			chunk_bytes += aligned(column.size * chunk_rows) + ticks;
+
+		auto *chunk = static_cast<char *>(Column::allocate(chunk_bytes));
+		if (!chunk)
+			throw std::bad_alloc();
+
+		chunks.emplace_back(chunk);
+		entity_blocks.emplace_back(reinterpret_cast<Entity *>(chunk));
+		for (size_t offset = handles; Column &column: columns)
+		{
+			char *block = chunk + offset;
+			char *block_ticks = block + aligned(column.size * chunk_rows);
+			std::memset(block_ticks, 0, ticks);
+			column.blocks.emplace_back(block);
+			column.tick_blocks.emplace_back(reinterpret_cast<Tick *>(block_ticks));
+			offset += aligned(column.size * chunk_rows) + ticks;
+		}
+
+		capacity += chunk_rows;
 	}
-}
\ No newline at end of file
+}
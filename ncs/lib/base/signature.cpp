@@ -0,0 +1,59 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <algorithm>
+#include <ncs/base/signature.hpp>
+
+namespace ncs
+{
+	Signature::Signature(const std::span<const Component> components)
+	{
+		for (const Component c: components)
+			set(c);
+	}
+
+	void Signature::set(const Component c)
+	{
+		if (c < INLINE_BITS)
+		{
+			words[c >> 6] |= uint64_t { 1 } << (c & 63);
+			return;
+		}
+
+		if (const auto it = std::ranges::lower_bound(overflow, c);
+			it == overflow.end() || *it != c)
+			overflow.insert(it, c);
+	}
+
+	void Signature::reset(const Component c)
+	{
+		if (c < INLINE_BITS)
+		{
+			words[c >> 6] &= ~(uint64_t { 1 } << (c & 63));
+			return;
+		}
+
+		if (const auto it = std::ranges::lower_bound(overflow, c);
+			it != overflow.end() && *it == c)
+			overflow.erase(it);
+	}
+
+	bool Signature::intersects(const Signature &mask) const
+	{
+		uint64_t common = 0;
+		for (size_t i = 0; i < WORDS; ++i)
+			common |= mask.words[i] & words[i];
+
+		if (common)
+			return true;
+
+		return std::ranges::any_of(mask.overflow, [this](const Component c)
+		{
+			return std::ranges::binary_search(overflow, c);
+		});
+	}
+
+	bool Signature::operator==(const Signature &other) const
+	{
+		return std::ranges::equal(words, other.words) && overflow == other.overflow;
+	}
+}
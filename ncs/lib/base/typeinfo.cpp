@@ -0,0 +1,13 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <atomic>
+#include <ncs/base/typeinfo.hpp>
+
+namespace ncs
+{
+	Component next_type_id()
+	{
+		static std::atomic<Component> next { 0 };
+		return next.fetch_add(1, std::memory_order_relaxed);
+	}
+}
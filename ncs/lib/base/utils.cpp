@@ -8,7 +8,7 @@ namespace ncs
 	constexpr auto FNV_PRIME = 1099511628211ULL;
 	constexpr auto FNV_OFFSET_BASIS = 14695981039346656037ULL;
 
-	uint64_t archash(const std::vector<Component>& components)
+	uint64_t archash(const std::span<const Component> components)
 	{
 		if (components.empty())
 			return 0; /* special case for empty vectors */
@@ -0,0 +1,134 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <ncs/sched/pool.hpp>
+
+namespace ncs
+{
+	/* lets a worker that calls run() recursively queue onto its own deque */
+	static thread_local const ThreadPool *current_pool = nullptr;
+	static thread_local size_t current_queue = 0;
+
+	ThreadPool::ThreadPool(const size_t threads) : queued(0), stopping(false)
+	{
+		const size_t count = threads == 0 ? 1 : threads;
+		for (size_t i = 0; i < count; ++i)
+			queues.emplace_back(std::make_unique<Queue>());
+
+		for (size_t i = 1; i < count; ++i)
+			workers.emplace_back(&ThreadPool::work, this, i);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard guard(sleep_lock);
+			stopping = true;
+		}
+
+		wake.notify_all();
+		for (auto &worker: workers)
+			worker.join();
+	}
+
+	size_t ThreadPool::size() const
+	{
+		return queues.size();
+	}
+
+	void ThreadPool::run(const size_t count, void (*fn)(void *, size_t), void *ctx)
+	{
+		if (count == 0)
+			return;
+
+		const size_t self = current_pool == this ? current_queue : 0;
+		std::atomic<size_t> pending = count;
+
+		/* hand every participant a contiguous range so neighbouring batches stay on one thread */
+		const size_t n = queues.size();
+		for (size_t q = 0; q < n; ++q)
+		{
+			const size_t target = (self + q) % n;
+			const size_t begin = q * count / n;
+			const size_t end = (q + 1) * count / n;
+			if (begin == end)
+				continue;
+
+			std::lock_guard guard(queues[target]->lock);
+			for (size_t i = begin; i < end; ++i)
+				queues[target]->tasks.push_back({ fn, ctx, i, &pending });
+		}
+
+		queued.fetch_add(count, std::memory_order_release);
+		{
+			std::lock_guard guard(sleep_lock); /* pairs with the predicate check in work() */
+		}
+		wake.notify_all();
+
+		/* help until this call's tasks are done; may run tasks of other calls meanwhile */
+		while (pending.load(std::memory_order_acquire) != 0)
+		{
+			if (Task task {}; pop(self, task))
+			{
+				task.fn(task.ctx, task.index);
+				task.pending->fetch_sub(1, std::memory_order_release);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	bool ThreadPool::pop(const size_t self, Task &task)
+	{
+		const size_t n = queues.size();
+		for (size_t i = 0; i < n; ++i)
+		{
+			Queue &queue = *queues[(self + i) % n];
+			std::lock_guard guard(queue.lock);
+			if (queue.tasks.empty())
+				continue;
+
+			if (i == 0) /* own work in order */
+			{
+				task = queue.tasks.front();
+				queue.tasks.pop_front();
+			}
+			else /* steal from the far end */
+			{
+				task = queue.tasks.back();
+				queue.tasks.pop_back();
+			}
+
+			queued.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		return false;
+	}
+
+	void ThreadPool::work(const size_t self)
+	{
+		current_pool = this;
+		current_queue = self;
+
+		while (true)
+		{
+			if (Task task {}; pop(self, task))
+			{
+				task.fn(task.ctx, task.index);
+				task.pending->fetch_sub(1, std::memory_order_release);
+				continue;
+			}
+
+			std::unique_lock guard(sleep_lock);
+			wake.wait(guard, [this]
+			{
+				return stopping || queued.load(std::memory_order_acquire) > 0;
+			});
+
+			if (stopping && queued.load(std::memory_order_acquire) == 0)
+				return;
+		}
+	}
+}
@@ -0,0 +1,68 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <ncs/sched/scheduler.hpp>
+
+namespace ncs
+{
+	Scheduler::Scheduler(World &world, ThreadPool &pool) : world(world), pool(pool), dirty(false) {}
+
+	void Scheduler::run()
+	{
+		if (dirty)
+			build();
+
+		for (const auto &stage: layers)
+		{
+			if (stage.size() == 1) /* nothing to overlap with */
+			{
+				systems[stage.front()].run(world);
+				continue;
+			}
+
+			pool.run(stage.size(), [this, &stage](const size_t index)
+			{
+				systems[stage[index]].run(world);
+			});
+		}
+	}
+
+	const std::vector<std::vector<size_t> > &Scheduler::stages()
+	{
+		if (dirty)
+			build();
+
+		return layers;
+	}
+
+	void Scheduler::build()
+	{
+		/*
+		 * an edge runs from every earlier system to each later one it conflicts with; a system lands one stage
+		 * after the deepest of its predecessors, so conflicting systems keep their registration order
+		 */
+		std::vector<size_t> depth(systems.size(), 0);
+		layers.clear();
+
+		for (size_t i = 0; i < systems.size(); ++i)
+		{
+			for (size_t j = 0; j < i; ++j)
+			{
+				if (conflicts(systems[j], systems[i]))
+					depth[i] = std::max(depth[i], depth[j] + 1);
+			}
+
+			if (depth[i] >= layers.size())
+				layers.resize(depth[i] + 1);
+
+			layers[depth[i]].emplace_back(i);
+		}
+
+		dirty = false;
+	}
+
+	bool Scheduler::conflicts(const System &a, const System &b)
+	{
+		/* write/write and read/write overlaps; shared reads are fine */
+		return a.exclusive || b.exclusive || a.writes.intersects(b.writes) || a.writes.intersects(b.reads) || a.reads.intersects(b.writes);
+	}
+}
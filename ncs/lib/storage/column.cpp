@@ -1,5 +1,8 @@
 /* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <ncs/storage/column.hpp>
 
@@ -9,47 +12,58 @@ namespace ncs
 
 	Column::~Column()
 	{
-		if (data)
-		{
-			std::free(data);
-			data = nullptr;
-		}
+		clear();
 	}
 
-	Column::Column(const Column &other) : size(other.size)
+	Column::Column(const Column &other) : id(other.id), size(other.size), relocate_fn(other.relocate_fn),
+	                                      added_ticks(other.added_ticks), changed_ticks(other.changed_ticks),
+	                                      added_max(other.added_max), changed_max(other.changed_max),
+	                                      blocks(other.blocks), tick_blocks(other.tick_blocks),
+	                                      block_shift(other.block_shift)
 	{
 		if (other.data && other.capacity > 0)
 		{
-			data = std::malloc(size * other.capacity);
+			data = allocate(size * other.capacity);
 			if (data)
 				std::memcpy(data, other.data, size * other.capacity);
 			capacity = other.capacity;
 		}
 	}
 
-	Column::Column(Column &&other) noexcept : data(other.data), size(other.size), capacity(other.capacity)
+	Column::Column(Column &&other) noexcept : id(other.id), data(other.data), size(other.size),
+	                                          capacity(other.capacity), owned(other.owned), relocate_fn(other.relocate_fn),
+	                                          added_ticks(std::move(other.added_ticks)),
+	                                          changed_ticks(std::move(other.changed_ticks)), added_max(other.added_max),
+	                                          changed_max(other.changed_max), blocks(std::move(other.blocks)),
+	                                          tick_blocks(std::move(other.tick_blocks)), block_shift(other.block_shift)
 	{
 		other.data = nullptr;
 		other.size = 0;
 		other.capacity = 0;
+		other.owned = true;
 	}
 
 	Column &Column::operator=(const Column &other)
 	{
 		if (this != &other)
 		{
-			if (data)
-			{
-				std::free(data);
-				data = nullptr;
-			}
+			clear();
 
+			id = other.id;
 			size = other.size;
 			capacity = other.capacity;
+			relocate_fn = other.relocate_fn;
+			added_ticks = other.added_ticks;
+			changed_ticks = other.changed_ticks;
+			added_max = other.added_max;
+			changed_max = other.changed_max;
+			blocks = other.blocks;
+			tick_blocks = other.tick_blocks;
+			block_shift = other.block_shift;
 
 			if (other.data && other.capacity > 0)
 			{
-				data = std::malloc(size * capacity);
+				data = allocate(size * capacity);
 				if (data)
 					std::memcpy(data, other.data, size * capacity);
 			}
@@ -61,62 +75,91 @@ namespace ncs
 	{
 		if (this != &other)
 		{
-			if (data)
-				std::free(data);
+			clear();
 
+			id = other.id;
 			data = other.data;
 			size = other.size;
 			capacity = other.capacity;
+			owned = other.owned;
+			relocate_fn = other.relocate_fn;
+			added_ticks = std::move(other.added_ticks);
+			changed_ticks = std::move(other.changed_ticks);
+			added_max = other.added_max;
+			changed_max = other.changed_max;
+			blocks = std::move(other.blocks);
+			tick_blocks = std::move(other.tick_blocks);
+			block_shift = other.block_shift;
 
 			/* leave empty */
 			other.data = nullptr;
 			other.size = 0;
 			other.capacity = 0;
+			other.owned = true;
 		}
 		return *this;
 	}
 
-	void Column::resize(const size_t nsz)
+	void Column::resize(const size_t nsz, const size_t rows)
 	{
 		if (nsz <= capacity)
 			return;
 
 		if (data == nullptr)
 		{
-			data = std::malloc(size * nsz);
+			data = allocate(size * nsz);
 			if (!data)
 				throw std::bad_alloc();
 		}
 		else /* realloc existing */
 		{
-			void *new_data = std::malloc(size * nsz);
+			void *new_data = allocate(size * nsz);
 			if (!new_data)
 				throw std::bad_alloc();
 
-			if (capacity > 0 && size > 0)
-				std::memcpy(new_data, data, size * capacity);
+			if (rows > 0 && size > 0)
+				relocate(new_data, data, std::min(rows, capacity)); /* one bulk memcpy for trivially relocatable types */
 
-			std::free(data);
+			if (owned)
+				std::free(data);
 			data = new_data;
 		}
 		capacity = nsz;
+		owned = true;
 	}
 
 	void Column::clear()
 	{
-		if (data)
-		{
+		if (data && owned)
 			std::free(data);
-			data = nullptr;
-		}
+
+		data = nullptr;
 		capacity = 0;
+		owned = true;
+	}
+
+	void Column::adopt(void *rows, const size_t count)
+	{
+		clear();
+		data = rows;
+		capacity = count;
+		owned = false;
 	}
 
 	void *Column::get(const size_t row) const
 	{
+		if (!blocks.empty())
+			return row < (blocks.size() << block_shift) ? at(row) : nullptr;
+
 		if (row >= capacity || !data)
 			return nullptr;
 
 		return static_cast<char *>(data) + (row * size);
 	}
+
+	void *Column::allocate(const size_t bytes)
+	{
+		const size_t rounded = (std::max(bytes, size_t { 1 }) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+		return std::aligned_alloc(ALIGNMENT, rounded);
+	}
 }
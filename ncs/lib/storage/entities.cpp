@@ -0,0 +1,120 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <algorithm>
+#include <ncs/storage/entities.hpp>
+
+namespace ncs
+{
+	EntityTable::EntityTable() : free_head(NIL), next_id(0), alive_count(0) {}
+
+	Entity EntityTable::create()
+	{
+		uint64_t id;
+		EntitySlot *s;
+
+		if (free_head != NIL)
+		{
+			/* recycling; the generation was already bumped by destroy() */
+			id = free_head;
+			s = &pages[id >> PAGE_SHIFT][id & PAGE_MASK];
+			free_head = s->record.row;
+		}
+		else
+		{
+			/* newborn path */
+			id = next_id++;
+			if ((id >> PAGE_SHIFT) >= pages.size())
+				pages.emplace_back(std::make_unique<EntitySlot[]>(PAGE_SIZE));
+
+			s = &pages[id >> PAGE_SHIFT][id & PAGE_MASK];
+		}
+
+		s->record = {};
+		s->alive = true;
+		++alive_count;
+		return (static_cast<Entity>(s->generation) << GENERATION_SHIFT) | id;
+	}
+
+	void EntityTable::create(const std::span<Entity> out)
+	{
+		/* recycled ids first, then one contiguous range of newborn ids */
+		size_t i = 0;
+		for (; i < out.size() && free_head != NIL; ++i)
+			out[i] = create();
+
+		const uint64_t first = next_id;
+		next_id += out.size() - i;
+		while (pages.size() << PAGE_SHIFT < next_id)
+			pages.emplace_back(std::make_unique<EntitySlot[]>(PAGE_SIZE));
+
+		for (uint64_t id = first; i < out.size(); ++i, ++id)
+		{
+			EntitySlot *s = &pages[id >> PAGE_SHIFT][id & PAGE_MASK];
+			s->record = {};
+			s->alive = true;
+			out[i] = (static_cast<Entity>(s->generation) << GENERATION_SHIFT) | id;
+		}
+
+		alive_count += next_id - first;
+	}
+
+	bool EntityTable::destroy(const Entity entity)
+	{
+		EntitySlot *s = find(entity);
+		if (!s)
+			return false;
+
+		const uint64_t id = entity & ENTITY_MASK;
+		s->alive = false;
+		s->generation = s->generation == MAX_GENERATION ? 0 : s->generation + 1; /* wrap around */
+		s->record.archetype = nullptr;
+		s->record.row = free_head; /* thread the free list through the dead slot */
+		free_head = id;
+		--alive_count;
+		return true;
+	}
+
+	void EntityTable::restore(const std::span<const Entity> live, const std::span<const Generation> generations)
+	{
+		uint64_t end = generations.size();
+		for (const Entity entity: live)
+			end = std::max(end, (entity & ENTITY_MASK) + 1);
+
+		pages.clear();
+		while (pages.size() << PAGE_SHIFT < end)
+			pages.emplace_back(std::make_unique<EntitySlot[]>(PAGE_SIZE));
+
+		for (const Entity entity: live)
+		{
+			EntitySlot *s = &pages[(entity & ENTITY_MASK) >> PAGE_SHIFT][entity & PAGE_MASK];
+			s->alive = true;
+			s->generation = static_cast<Generation>(entity >> GENERATION_SHIFT);
+		}
+
+		/* threaded from the top so the lowest free id is reused first */
+		free_head = NIL;
+		for (uint64_t id = end; id-- > 0;)
+		{
+			if (EntitySlot *s = &pages[id >> PAGE_SHIFT][id & PAGE_MASK];
+				!s->alive)
+			{
+				s->generation = id < generations.size() ? generations[id] : 0;
+				s->record.row = free_head;
+				free_head = id;
+			}
+		}
+
+		next_id = end;
+		alive_count = live.size();
+	}
+
+	size_t EntityTable::alive() const
+	{
+		return alive_count;
+	}
+
+	uint64_t EntityTable::size() const
+	{
+		return next_id;
+	}
+}
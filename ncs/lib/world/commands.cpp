@@ -0,0 +1,225 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include <ncs/world/commands.hpp>
+
+namespace ncs
+{
+	Commands::Commands(World &world) : world(world) {}
+
+	Commands::~Commands()
+	{
+		clear();
+	}
+
+	Commands &Commands::despawn(const Entity entity)
+	{
+		push({ entity, Op::DESPAWN, nullptr });
+		return *this;
+	}
+
+	void Commands::apply()
+	{
+		std::vector<Command> pending;
+		for (Shard &s: shards)
+		{
+			std::lock_guard guard(s.lock);
+			pending.insert(pending.end(), s.commands.begin(), s.commands.end());
+			s.commands.clear();
+		}
+
+		/* group by entity; stable so one thread's commands for an entity keep their order */
+		std::ranges::stable_sort(pending, {}, &Command::entity);
+
+		struct Move
+		{
+			Entity entity;
+			Archetype *source;      /* nullptr when the entity had no components */
+			Archetype *destination; /* after every command of the entity */
+			size_t first, last;     /* the entity's commands in pending */
+		};
+
+		std::vector<Move> moves;
+		std::vector<Entity> doomed;
+		std::vector<Component> cids(pending.size());
+
+		/* net ids added and removed per entity; the final archetype is one bundle edge away */
+		Archetype *root = world.find_archetype({});
+		std::vector<Component> added, removed;
+		for (size_t first = 0, last; first < pending.size(); first = last)
+		{
+			const Entity entity = pending[first].entity;
+			auto despawned = false;
+			for (last = first; last < pending.size() && pending[last].entity == entity; ++last)
+				despawned |= pending[last].op == Op::DESPAWN;
+
+			if (despawned || !world.alive(entity))
+			{
+				for (size_t i = first; i < last; ++i)
+				{
+					if (pending[i].op == Op::SET)
+						pending[i].destroy(pending[i].value);
+				}
+
+				if (despawned)
+					doomed.emplace_back(entity);
+				continue;
+			}
+
+			Archetype *source = world.archetype_of(entity);
+			Archetype *current = source ? source : root;
+			added.clear();
+			removed.clear();
+			for (size_t i = first; i < last; ++i)
+			{
+				const Component c = cids[i] = pending[i].resolve(world);
+				const bool set = pending[i].op == Op::SET;
+				std::vector<Component> &into = set ? added : removed;
+				std::erase(set ? removed : added, c);
+
+				/* setting an id the source has, or removing one it lacks, is not structural */
+				if (current->has(c) != set && std::ranges::find(into, c) == into.end())
+					into.emplace_back(c);
+			}
+
+			moves.push_back({ entity, source, world.find_archetype_delta(current, added, removed), first, last });
+		}
+
+		/* one batch per (source, destination) pair */
+		constexpr std::less<Archetype *> less;
+		std::ranges::sort(moves, [&less](const Move &a, const Move &b)
+		{
+			return a.source != b.source ? less(a.source, b.source) : less(a.destination, b.destination);
+		});
+
+		/* a destination reached from several sources grows once, for all of them, before the first batch */
+		std::unordered_map<Archetype *, size_t> arriving;
+		for (const Move &move: moves)
+		{
+			if (move.source != move.destination && (move.source || move.destination != root))
+				++arriving[move.destination];
+		}
+
+		for (const auto &[destination, count]: arriving)
+			destination->reserve(destination->entity_count + count);
+
+		std::vector<Entity> batch;
+		for (size_t first = 0, last; first < moves.size(); first = last)
+		{
+			Archetype *source = moves[first].source;
+			Archetype *destination = moves[first].destination;
+
+			batch.clear();
+			for (last = first; last < moves.size() && moves[last].source == source &&
+			                   moves[last].destination == destination; ++last)
+				batch.emplace_back(moves[last].entity);
+
+			if (source || destination != root) /* component-less entities that stay so are left alone */
+				world.move_batch(source, destination, batch);
+		}
+
+		/* last write wins; earlier values and values cancelled by a later remove are dropped */
+		std::vector<Component> seen;
+		for (const Move &move: moves)
+		{
+			seen.clear();
+			for (size_t i = move.last; i-- > move.first;)
+			{
+				const Command &command = pending[i];
+				const bool shadowed = std::ranges::find(seen, cids[i]) != seen.end();
+				if (!shadowed)
+					seen.emplace_back(cids[i]);
+
+				if (command.op != Op::SET)
+					continue;
+
+				if (shadowed)
+				{
+					command.destroy(command.value);
+					continue;
+				}
+
+				void *slot = world.component_ptr(move.entity, cids[i]);
+				if (!slot) /* tags have no column; the move was all there was to do */
+				{
+					command.destroy(command.value);
+					continue;
+				}
+
+				if (move.source && move.source->has(cids[i])) /* the old value was carried over */
+					command.destroy(slot);
+
+				command.relocate(slot, command.value);
+				world.mark_changed(move.entity, cids[i]);
+			}
+		}
+
+		for (const Entity entity: doomed)
+			world.despawn(entity);
+
+		for (Shard &s: shards)
+		{
+			std::lock_guard guard(s.lock);
+			release(s);
+		}
+	}
+
+	void Commands::clear()
+	{
+		for (Shard &s: shards)
+		{
+			std::lock_guard guard(s.lock);
+			for (const Command &command: s.commands)
+			{
+				if (command.op == Op::SET)
+					command.destroy(command.value);
+			}
+
+			s.commands.clear();
+			release(s);
+		}
+	}
+
+	Commands::Shard &Commands::shard()
+	{
+		return shards[std::hash<std::thread::id> {}(std::this_thread::get_id()) % SHARDS];
+	}
+
+	void *Commands::allocate(Shard &shard, const size_t size, const size_t align)
+	{
+		shard.used = (shard.used + align - 1) & ~(align - 1);
+		if (shard.blocks.empty() || shard.used + size > BLOCK_SIZE)
+		{
+			void *block = Column::allocate(std::max(size, BLOCK_SIZE)); /* oversized values get a block of their own */
+			if (!block)
+				throw std::bad_alloc();
+
+			shard.blocks.emplace_back(block);
+			shard.used = 0;
+		}
+
+		void *ptr = static_cast<char *>(shard.blocks.back()) + shard.used;
+		shard.used += size;
+		return ptr;
+	}
+
+	void Commands::push(const Command &command)
+	{
+		Shard &s = shard();
+		std::lock_guard guard(s.lock);
+		s.commands.emplace_back(command);
+	}
+
+	void Commands::release(Shard &shard)
+	{
+		for (void *block: shard.blocks)
+			std::free(block);
+
+		shard.blocks.clear();
+		shard.used = 0;
+	}
+}
@@ -0,0 +1,433 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <cstring>
+#include <ncs/world/journal.hpp>
+
+namespace ncs
+{
+	enum : uint8_t
+	{
+		OP_ARCHETYPE,
+		OP_MOVE,
+		OP_DESPAWN,
+	};
+
+	static void put_varint(std::vector<std::byte> &out, uint64_t value)
+	{
+		for (; value >= 0x80; value >>= 7)
+			out.push_back(static_cast<std::byte>(value | 0x80));
+		out.push_back(static_cast<std::byte>(value));
+	}
+
+	static void put_fixed(std::vector<std::byte> &out, const uint64_t value)
+	{
+		const auto *bytes = reinterpret_cast<const std::byte *>(&value);
+		out.insert(out.end(), bytes, bytes + sizeof(value));
+	}
+
+	/* bounds-checked reads; any overrun leaves ok false and every later read failing */
+	struct Reader
+	{
+		const std::byte *at;
+		const std::byte *end;
+		bool ok = true;
+
+		uint64_t varint()
+		{
+			uint64_t value = 0;
+			for (int shift = 0; ok; shift += 7)
+			{
+				if (at == end || shift > 63)
+				{
+					ok = false;
+					break;
+				}
+
+				const auto b = static_cast<uint8_t>(*at++);
+				value |= static_cast<uint64_t>(b & 0x7F) << shift;
+				if (!(b & 0x80))
+					break;
+			}
+
+			return value;
+		}
+
+		uint64_t fixed()
+		{
+			uint64_t value = 0;
+			if (const std::byte *bytes = take(sizeof(value)))
+				std::memcpy(&value, bytes, sizeof(value));
+			return value;
+		}
+
+		const std::byte *take(const uint64_t count)
+		{
+			if (!ok || count > static_cast<uint64_t>(end - at))
+			{
+				ok = false;
+				return nullptr;
+			}
+
+			const std::byte *bytes = at;
+			at += count;
+			return bytes;
+		}
+	};
+
+	/* the ids a journal can name: registered, trivially copyable or tags, and not pairs or shared values */
+	static bool journaled(const World &world, const Component c)
+	{
+		if (c & (PAIR_FLAG | SHARED_FLAG))
+			return false;
+
+		const std::span<const TypeInfo> types = world.type_table();
+		return c < types.size() && types[c].key != 0 && types[c].trivial;
+	}
+
+	Journal::Journal(World &world) : world(&world)
+	{
+		world.record(this);
+		for (const Archetype *arch: world.archetype_table())
+		{
+			for (size_t row = 0; row < arch->entity_count; ++row)
+				moved(*arch->entity_at(row), arch);
+		}
+	}
+
+	Journal::~Journal()
+	{
+		if (world)
+			world->record(nullptr);
+	}
+
+	size_t Journal::commit(std::vector<std::byte> &out)
+	{
+		const size_t start = out.size();
+		out.resize(start + sizeof(uint32_t)); /* the length goes in once the payload is known */
+
+		put_varint(out, world ? world->tick() : since);
+		put_varint(out, op_count);
+		out.insert(out.end(), ops.begin(), ops.end());
+		ops.clear();
+		op_count = 0;
+
+		/* one group per archetype column with rows written since the last frame */
+		std::vector<std::byte> groups;
+		size_t group_count = 0;
+		std::vector<Entity> rows;
+		std::vector<std::byte> previous;
+		std::vector<std::byte> literal;
+		for (const Archetype *arch: world ? world->archetype_table() : std::span<Archetype *const>())
+		{
+			for (const Component c: arch->components)
+			{
+				const Column *found = arch->column(c);
+				if (!found || !journaled(*world, c) || found->changed_max < since)
+					continue;
+
+				const Column &column = *found;
+				rows.clear();
+				for (size_t row = 0; row < arch->entity_count; ++row)
+				{
+					if (column.changed(row) >= since)
+						rows.emplace_back(row);
+				}
+
+				if (rows.empty())
+					continue;
+
+				++group_count;
+				put_fixed(groups, world->type_table()[c].key);
+				put_varint(groups, column.size);
+				put_varint(groups, rows.size());
+
+				Entity last = 0;
+				for (const size_t row: rows)
+				{
+					const Entity entity = *arch->entity_at(row);
+					const auto delta = static_cast<int64_t>(entity - last);
+					put_varint(groups, static_cast<uint64_t>(delta << 1) ^ static_cast<uint64_t>(delta >> 63));
+					last = entity;
+				}
+
+				/* neighbouring rows tend to hold similar values; their XOR is mostly zero bytes */
+				previous.assign(column.size, std::byte { 0 });
+				literal.clear();
+				uint64_t zeros = 0;
+				const auto flush = [&groups, &zeros, &literal]
+				{
+					put_varint(groups, zeros);
+					put_varint(groups, literal.size());
+					groups.insert(groups.end(), literal.begin(), literal.end());
+					zeros = 0;
+					literal.clear();
+				};
+
+				for (const size_t row: rows)
+				{
+					const auto *value = static_cast<const std::byte *>(column.at(row));
+					for (size_t b = 0; b < column.size; ++b)
+					{
+						const std::byte x = value[b] ^ previous[b];
+						if (x != std::byte { 0 })
+						{
+							literal.push_back(x);
+							continue;
+						}
+
+						if (!literal.empty())
+							flush();
+						++zeros;
+					}
+
+					std::memcpy(previous.data(), value, column.size);
+				}
+
+				if (zeros || !literal.empty())
+					flush();
+			}
+		}
+
+		put_varint(out, group_count);
+		out.insert(out.end(), groups.begin(), groups.end());
+
+		const auto length = static_cast<uint32_t>(out.size() - start - sizeof(uint32_t));
+		std::memcpy(out.data() + start, &length, sizeof(length));
+
+		if (world)
+			since = world->tick() + 1;
+		return out.size() - start;
+	}
+
+	void Journal::moved(const Entity entity, const Archetype *archetype)
+	{
+		if (archetype)
+		{
+			if (archetype->index >= announced.size())
+				announced.resize(archetype->index + 1);
+
+			if (!announced[archetype->index])
+			{
+				announced[archetype->index] = true;
+
+				size_t count = 0;
+				for (const Component c: archetype->components)
+					count += journaled(*world, c);
+
+				ops.push_back(std::byte { OP_ARCHETYPE });
+				put_varint(ops, archetype->index);
+				put_varint(ops, count);
+				for (const Component c: archetype->components)
+				{
+					if (journaled(*world, c))
+						put_fixed(ops, world->type_table()[c].key);
+				}
+				++op_count;
+			}
+		}
+
+		ops.push_back(std::byte { OP_MOVE });
+		put_varint(ops, entity);
+		put_varint(ops, archetype ? archetype->index + 1 : 0);
+		++op_count;
+	}
+
+	void Journal::despawned(const Entity entity)
+	{
+		ops.push_back(std::byte { OP_DESPAWN });
+		put_varint(ops, entity);
+		++op_count;
+	}
+
+	void Journal::detach()
+	{
+		world = nullptr;
+	}
+
+	Replay::Replay(World &world) : world(world) {}
+
+	bool Replay::apply(const std::span<const std::byte> bytes)
+	{
+		for (size_t at = 0; at < bytes.size();)
+		{
+			uint32_t length;
+			if (bytes.size() - at < sizeof(length))
+				return false;
+
+			std::memcpy(&length, bytes.data() + at, sizeof(length));
+			at += sizeof(length);
+			if (length > bytes.size() - at || !frame(bytes.subspan(at, length)))
+				return false;
+			at += length;
+		}
+
+		return true;
+	}
+
+	Entity Replay::entity(const Entity recorded) const
+	{
+		const auto it = entities.find(recorded);
+		return it != entities.end() ? it->second : NONE;
+	}
+
+	Tick Replay::tick() const
+	{
+		return last;
+	}
+
+	bool Replay::frame(const std::span<const std::byte> payload)
+	{
+		Reader in { payload.data(), payload.data() + payload.size() };
+
+		/* the keys this world knows, gathered per frame so types registered between frames are found */
+		const std::span<const TypeInfo> types = world.type_table();
+		std::unordered_map<uint64_t, Component> ids;
+		for (Component c = 0; c < types.size(); ++c)
+		{
+			if (types[c].key && types[c].trivial)
+				ids.emplace(types[c].key, c);
+		}
+
+		const auto resolve = [&ids](const uint64_t key, Component &id)
+		{
+			const auto it = ids.find(key);
+			if (it == ids.end())
+				return false;
+			id = it->second;
+			return true;
+		};
+
+		const auto tick = static_cast<Tick>(in.varint());
+		const uint64_t op_count = in.varint();
+		std::vector<Component> components;
+		for (uint64_t i = 0; i < op_count && in.ok; ++i)
+		{
+			const std::byte *op = in.take(1);
+			if (!op)
+				break;
+
+			switch (static_cast<uint8_t>(*op))
+			{
+				case OP_ARCHETYPE:
+				{
+					const uint64_t index = in.varint();
+					const uint64_t count = in.varint();
+					if (!in.ok || count > payload.size())
+						return false;
+
+					components.clear();
+					for (uint64_t k = 0; k < count; ++k)
+					{
+						Component id;
+						if (!resolve(in.fixed(), id) || !in.ok)
+							return false;
+						components.emplace_back(id);
+					}
+
+					if (index >= archetypes.size())
+						archetypes.resize(index + 1);
+					archetypes[index] = world.create_archetype(components);
+					break;
+				}
+				case OP_MOVE:
+				{
+					const Entity recorded = in.varint();
+					const uint64_t index = in.varint();
+					if (!in.ok || (index && (index > archetypes.size() || !archetypes[index - 1])))
+						return false;
+
+					auto [it, inserted] = entities.try_emplace(recorded, 0);
+					if (inserted)
+						it->second = world.entity(); /* an entity appears with its first move */
+					world.place(it->second, index ? archetypes[index - 1] : nullptr);
+					break;
+				}
+				case OP_DESPAWN:
+				{
+					const Entity recorded = in.varint();
+					if (const auto it = entities.find(recorded);
+						it != entities.end())
+					{
+						world.despawn(it->second);
+						entities.erase(it);
+					}
+					break;
+				}
+				default:
+					return false;
+			}
+		}
+
+		const uint64_t group_count = in.varint();
+		std::vector<Entity> rows;
+		std::vector<std::byte> value;
+		for (uint64_t g = 0; g < group_count && in.ok; ++g)
+		{
+			Component id;
+			if (!resolve(in.fixed(), id))
+				return false;
+
+			const uint64_t size = in.varint();
+			const uint64_t count = in.varint();
+			if (!in.ok || size != types[id].size || size == 0 || count > payload.size())
+				return false;
+
+			rows.resize(count);
+			Entity last_entity = 0;
+			for (Entity &entity: rows)
+			{
+				const uint64_t zigzag = in.varint();
+				last_entity += static_cast<Entity>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+				entity = last_entity;
+			}
+
+			/* undo the runs into one row at a time; each row is XOR'd onto the one before */
+			value.assign(size, std::byte { 0 });
+			uint64_t zeros = 0, literals = 0;
+			const std::byte *literal = nullptr;
+			for (const Entity recorded: rows)
+			{
+				for (uint64_t b = 0; b < size; ++b)
+				{
+					while (in.ok && zeros == 0 && literals == 0)
+					{
+						zeros = in.varint();
+						literals = in.varint();
+						literal = in.take(literals);
+					}
+
+					if (!in.ok)
+						return false;
+
+					if (zeros)
+					{
+						--zeros;
+						continue;
+					}
+
+					value[b] ^= *literal++;
+					--literals;
+				}
+
+				const auto it = entities.find(recorded);
+				if (it == entities.end())
+					continue;
+
+				if (void *slot = world.component_ptr(it->second, id))
+				{
+					std::memcpy(slot, value.data(), size);
+					world.mark_changed(it->second, id);
+				}
+			}
+
+			if (zeros || literals)
+				return false;
+		}
+
+		if (!in.ok || in.at != in.end)
+			return false;
+
+		last = tick;
+		return true;
+	}
+}
@@ -0,0 +1,56 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <algorithm>
+#include <ncs/world/prefab.hpp>
+
+namespace ncs
+{
+	Prefab::Prefab(World &world) : world(world) {}
+
+	Prefab::~Prefab()
+	{
+		for (Default &value: defaults)
+			release(value);
+
+		for (const Component id: shared_ids)
+			world.release_shared(id);
+	}
+
+	Archetype *Prefab::archetype()
+	{
+		if (!resolved)
+			resolved = world.create_archetype(ids);
+		return resolved;
+	}
+
+	void Prefab::fill(Archetype *archetype, const size_t row, const size_t count) const
+	{
+		for (const Default &value: defaults)
+		{
+			if (value.data)
+				value.fill(archetype->column(value.id)->at(row), value.data, count);
+		}
+	}
+
+	std::span<const Component> Prefab::shared() const
+	{
+		return shared_ids;
+	}
+
+	void Prefab::add(const Component id)
+	{
+		if (const auto it = std::ranges::lower_bound(ids, id);
+			it == ids.end() || *it != id)
+			ids.insert(it, id);
+
+		resolved = nullptr;
+	}
+
+	void Prefab::release(Default &value)
+	{
+		if (value.data)
+			value.destroy(value.data);
+
+		value = { value.id };
+	}
+}
@@ -0,0 +1,327 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <ncs/world/snapshot.hpp>
+#include <ncs/world/world.hpp>
+
+namespace ncs
+{
+	static uint64_t align_up(const uint64_t offset)
+	{
+		return (offset + Column::ALIGNMENT - 1) & ~uint64_t { Column::ALIGNMENT - 1 };
+	}
+
+	bool World::save(const std::string &path) const
+	{
+		std::vector<const Archetype *> saved;
+		size_t entries = 0;
+		for (const Archetype *arch: archetypes)
+		{
+			if (arch->entity_count == 0 || arch->components.empty()) /* rows of the root go with the bare handles */
+				continue;
+
+			for (const Component c: arch->components)
+			{
+				/* pair and shared value ids are per world; raw bytes of anything non-trivial are meaningless */
+				if ((c & (PAIR_FLAG | SHARED_FLAG)) || c >= types.size() || types[c].key == 0 || !types[c].trivial)
+					return false;
+			}
+
+			saved.emplace_back(arch);
+			entries += arch->components.size();
+		}
+
+		/* the layout first; every offset is known before a byte is written */
+		SnapshotHeader header;
+		header.archetypes = saved.size();
+		std::vector<SnapshotArchetype> tables(saved.size());
+		std::vector<SnapshotColumn> columns(entries);
+
+		uint64_t offset = sizeof(SnapshotHeader) + saved.size() * sizeof(SnapshotArchetype);
+		for (size_t i = 0; i < saved.size(); ++i)
+		{
+			tables[i].rows = saved[i]->entity_count;
+			tables[i].components = saved[i]->components.size();
+			tables[i].columns = offset;
+			offset += tables[i].components * sizeof(SnapshotColumn);
+			header.entities += tables[i].rows;
+		}
+
+		/* every entity is written; those without components only as a handle */
+		std::vector<Generation> generations(entities.size());
+		std::vector<Entity> bare;
+		for (uint64_t id = 0; id < generations.size(); ++id)
+		{
+			const EntitySlot *slot = entities.slot(id);
+			generations[id] = slot->generation;
+			if (slot->alive && (!slot->record.archetype || slot->record.archetype->components.empty()))
+				bare.emplace_back(encode_entity(id, slot->generation));
+		}
+
+		header.slots = generations.size();
+		header.generations = offset = align_up(offset);
+		offset += generations.size() * sizeof(Generation);
+		header.bare = bare.size();
+		header.bare_entities = offset = align_up(offset);
+		offset += bare.size() * sizeof(Entity);
+
+		for (size_t i = 0, entry = 0; i < saved.size(); ++i)
+		{
+			tables[i].entities = offset = align_up(offset);
+			offset += tables[i].rows * sizeof(Entity);
+			for (const Component c: saved[i]->components)
+			{
+				SnapshotColumn &column = columns[entry++];
+				column.key = types[c].key;
+				column.size = types[c].size;
+				if (column.size == 0)
+					continue;
+
+				column.offset = offset = align_up(offset);
+				offset += tables[i].rows * column.size;
+			}
+		}
+
+		header.size = offset;
+
+		std::FILE *file = std::fopen(path.c_str(), "wb");
+		if (!file)
+			return false;
+
+		uint64_t at = 0;
+		auto ok = true;
+		const auto put = [file, &at, &ok](const void *bytes, const size_t count)
+		{
+			ok = ok && std::fwrite(bytes, 1, count, file) == count;
+			at += count;
+		};
+
+		const auto pad = [&put, &at](const uint64_t to)
+		{
+			constexpr char zeros[Column::ALIGNMENT] = {};
+			put(zeros, to - at);
+		};
+
+		put(&header, sizeof(header));
+		put(tables.data(), tables.size() * sizeof(SnapshotArchetype));
+		put(columns.data(), columns.size() * sizeof(SnapshotColumn));
+		pad(header.generations);
+		put(generations.data(), generations.size() * sizeof(Generation));
+		pad(header.bare_entities);
+		put(bare.data(), bare.size() * sizeof(Entity));
+		for (size_t i = 0, entry = 0; i < saved.size(); ++i)
+		{
+			const Archetype *arch = saved[i];
+			pad(tables[i].entities);
+			for (size_t row = 0, run; row < arch->entity_count; row += run)
+			{
+				run = arch->run(row);
+				put(arch->entity_at(row), run * sizeof(Entity));
+			}
+
+			for (const Component c: arch->components)
+			{
+				const SnapshotColumn &entry_column = columns[entry++];
+				if (entry_column.size == 0)
+					continue;
+
+				/* a run at a time; one write per column in a contiguous archetype */
+				pad(entry_column.offset);
+				const Column &column = *arch->column(c);
+				for (size_t row = 0, run; row < arch->entity_count; row += run)
+				{
+					run = std::min(arch->run(row), arch->entity_count - row);
+					put(column.at(row), run * column.size);
+				}
+			}
+		}
+
+		return std::fclose(file) == 0 && ok;
+	}
+
+	bool World::load(const std::string &path, const Restore mode)
+	{
+		if (entities.alive() != 0)
+			return false;
+
+		const int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat info {};
+		if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(SnapshotHeader)))
+		{
+			close(fd);
+			return false;
+		}
+
+		/* private and writable; adopted columns take writes, the kernel copies the pages touched */
+		const auto size = static_cast<size_t>(info.st_size);
+		void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (data == MAP_FAILED)
+			return false;
+
+		const bool adopt = mode == Restore::ADOPT && storage == Storage::CONTIGUOUS;
+		if (!restore(static_cast<char *>(data), size, adopt))
+		{
+			munmap(data, size);
+			return false;
+		}
+
+		if (adopt)
+			mappings.push_back({ data, size });
+		else
+			munmap(data, size);
+		return true;
+	}
+
+	bool World::restore(char *file, const size_t size, const bool adopt)
+	{
+		const auto within = [size](const uint64_t offset, const uint64_t count, const uint64_t width)
+		{
+			return offset <= size && (width == 0 || count <= (size - offset) / width);
+		};
+
+		const auto *header = reinterpret_cast<const SnapshotHeader *>(file);
+		if (header->magic != SNAPSHOT_MAGIC || header->version != SNAPSHOT_VERSION || header->size != size ||
+		    !within(sizeof(SnapshotHeader), header->archetypes, sizeof(SnapshotArchetype)) ||
+		    !within(header->generations, header->slots, sizeof(Generation)) || header->generations % alignof(Generation) ||
+		    !within(header->bare_entities, header->bare, sizeof(Entity)) || header->bare_entities % alignof(Entity))
+			return false;
+
+		std::unordered_map<uint64_t, Component> ids;
+		for (Component c = 0; c < types.size(); ++c)
+		{
+			if (types[c].key)
+				ids.emplace(types[c].key, c);
+		}
+
+		/* every table is checked before the world is touched */
+		struct Plan
+		{
+			const SnapshotArchetype *table;
+			const SnapshotColumn *columns;
+			std::vector<Component> components;
+		};
+
+		std::vector<Plan> plans(header->archetypes);
+		std::set<std::vector<Component> > signatures;
+		std::vector<Entity> live;
+		const auto *tables = reinterpret_cast<const SnapshotArchetype *>(file + sizeof(SnapshotHeader));
+		for (size_t i = 0; i < plans.size(); ++i)
+		{
+			const SnapshotArchetype &table = tables[i];
+			if (!within(table.columns, table.components, sizeof(SnapshotColumn)) ||
+			    !within(table.entities, table.rows, sizeof(Entity)) ||
+			    table.columns % alignof(SnapshotColumn) || table.entities % alignof(Entity))
+				return false;
+
+			Plan &plan = plans[i];
+			plan.table = &table;
+			plan.columns = reinterpret_cast<const SnapshotColumn *>(file + table.columns);
+			for (size_t c = 0; c < table.components; ++c)
+			{
+				const SnapshotColumn &column = plan.columns[c];
+				const auto it = ids.find(column.key);
+				if (it == ids.end() || types[it->second].size != column.size || !types[it->second].trivial)
+					return false;
+
+				if (column.size && (!within(column.offset, table.rows, column.size) || column.offset % Column::ALIGNMENT))
+					return false;
+
+				plan.components.emplace_back(it->second);
+			}
+
+			/* one table per component set, each id once; a repeat would land in rows another table already filled */
+			std::vector<Component> sorted = plan.components;
+			std::ranges::sort(sorted);
+			if (std::ranges::adjacent_find(sorted) != sorted.end() || !signatures.insert(std::move(sorted)).second)
+				return false;
+
+			const auto *handles = reinterpret_cast<const Entity *>(file + table.entities);
+			live.insert(live.end(), handles, handles + table.rows);
+		}
+
+		/* each live handle once, and with the generation its id has in the file */
+		const auto *bare = reinterpret_cast<const Entity *>(file + header->bare_entities);
+		live.insert(live.end(), bare, bare + header->bare);
+		const auto *generations = reinterpret_cast<const Generation *>(file + header->generations);
+		std::vector<bool> seen(header->slots);
+		for (const Entity entity: live)
+		{
+			const uint64_t id = get_eid(entity);
+			if (id >= header->slots || seen[id] || generations[id] != get_egen(entity))
+				return false;
+			seen[id] = true;
+		}
+
+		entities.restore(live, { generations, header->slots });
+		for (const Plan &plan: plans)
+		{
+			const size_t rows = plan.table->rows;
+			const auto *handles = reinterpret_cast<const Entity *>(file + plan.table->entities);
+			Archetype *arch = create_archetype(plan.components); /* empty; the world had no live entities */
+			if (rows == 0)
+				continue;
+
+			if (adopt)
+			{
+				/* the handles are copied, the rows are not; capacity is exactly rows, so growth copies them out */
+				arch->entities.assign(handles, handles + rows);
+				arch->entity_count = arch->capacity = rows;
+				arch->flags |= DirtyFlags::ADDED;
+				++arch->version;
+			}
+			else
+			{
+				arch->append(std::span(handles, rows));
+			}
+
+			for (size_t c = 0; c < plan.components.size(); ++c)
+			{
+				const SnapshotColumn &entry = plan.columns[c];
+				if (entry.size == 0)
+					continue;
+
+				Column &column = *arch->column(plan.components[c]);
+				if (adopt)
+				{
+					column.adopt(file + entry.offset, rows);
+					column.added_ticks.assign(rows, current_tick);
+					column.changed_ticks.assign(rows, current_tick);
+				}
+				else
+				{
+					for (size_t row = 0, run; row < rows; row += run)
+					{
+						run = std::min(arch->run(row), rows - row);
+						std::memcpy(column.at(row), file + entry.offset + row * entry.size, run * entry.size);
+					}
+
+					for (size_t row = 0; row < rows; ++row)
+						column.mark_added(row, current_tick);
+				}
+
+				/* every row counts as added now, as if spawned */
+				column.added_max = column.changed_max = current_tick;
+			}
+
+			for (size_t row = 0; row < rows; ++row)
+			{
+				entities.slot(get_eid(handles[row]))->record = { arch, row };
+				moved(handles[row], arch);
+			}
+		}
+
+		return true;
+	}
+}
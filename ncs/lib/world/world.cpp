@@ -1,121 +1,148 @@
 /* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
 
+#include <array>
+#include <bit>
+#include <functional>
+#include <sys/mman.h>
 #include <ncs/base/utils.hpp>
+#include <ncs/world/journal.hpp>
+#include <ncs/world/prefab.hpp>
 #include <ncs/world/world.hpp>
 
 namespace ncs
 {
-	constexpr uint64_t ENTITY_MASK = 0x0000FFFFFFFFFFFF; /* 48 lower bits for entity id */
-	constexpr uint64_t GENERATION_SHIFT = 48; /* we need to shift 16 bits upper to accommodate the entity bits */
-	constexpr Generation MAX_GENERATION = 0xFFFF; /* for 16-bit generation */
+	/* calls func with count scratch ids; on the stack unless count is large */
+	template<size_t N, typename Func>
+	static Archetype *with_scratch(const size_t count, Func &&func)
+	{
+		if (count <= N)
+		{
+			std::array<Component, N> buffer;
+			return func(std::span(buffer.data(), count));
+		}
+
+		std::vector<Component> buffer(count);
+		return func(std::span(buffer));
+	}
 
-	World::World() : root_archetype(create_archetype({})), alive_count(0), next_eid(0), next_cid(0) {}
+	World::World() : World(Storage::CONTIGUOUS) {}
+
+	World::World(const Storage storage) : storage(storage), root_archetype(create_archetype({})),
+	                                      current_tick(1) {}
 
 	World::~World()
 	{
-		for (auto& [hash, cache_entry] : qcaches)
+		if (journal)
+			journal->detach();
+
+		for (auto& [hash, state] : qcaches)
 		{
-			auto& [ptr, del] = cache_entry;
-			del(ptr);
+			for (const QueryState::Rows &rows : state->rows)
+				rows.release(rows.cache);
+			delete state;
 		}
 		qcaches.clear();
 
-		for (auto& [hash, archetype] : archetypes)
+		for (const Resource &r : resources)
 		{
-			for (auto& [c, edge] : archetype->add_edge)
-				delete edge;
-			for (auto& [c, edge] : archetype->remove_edge)
-				delete edge;
+			if (r.data)
+				r.destroy(r.data);
+		}
+
+		for (const SharedValue &value : shared)
+		{
+			if (value.data)
+				value.destroy(value.data);
+		}
+
+		for (Archetype *archetype : archetypes)
+		{
+			/* components still alive at shutdown are destroyed like on despawn */
+			for (Column &column: archetype->columns)
+			{
+				if (const auto destroy = types[column.id].destroy)
+				{
+					for (size_t row = 0; row < archetype->entity_count; ++row)
+						destroy(column.at(row));
+				}
+			}
 
 			delete archetype;
 		}
 		archetypes.clear();
+
+		for (const Mapping &mapping : mappings)
+			munmap(mapping.data, mapping.size);
 	}
 
 	Entity World::entity()
 	{
-		Entity entity;
-		Generation gen;
-
-		if (alive_count < entity_pool.size())
-		{
-			/* recycling */
-			entity = entity_pool[alive_count]; /* get the entity id to recycle */
-
-			const auto it = generations.find(entity);
-			gen = (it != generations.end() ? it->second : 0) + 1;
-
-			/* wrap around if generation is overflow */
-			gen = gen > MAX_GENERATION /* 16-bit */ ? 0 : gen;
-		}
-		else
-		{
-			/* newborn path */
-			entity = next_eid;
-			++next_eid;
-			gen = 0;
-
-			/* add to the pool */
-			entity_pool.emplace_back(entity);
-		}
+		return entities.create();
+	}
 
-		++alive_count;
-		generations[entity] = gen;
-		entity_indices[entity] = alive_count - 1; /* store entity's position in the pool */
-		return encode_entity(entity, gen);
+	std::vector<Entity> World::instantiate(Prefab &prefab, const size_t count)
+	{
+		std::vector<Entity> batch(count);
+		stamp(prefab, batch);
+		return batch;
 	}
 
 	void World::despawn(const Entity entity)
 	{
-		const uint64_t entity_id = get_eid(entity);
-		const Generation gen = get_egen(entity);
-
 		/* check if the entity exists with valid generation */
-		if (const auto it = generations.find(entity_id);
-			it == generations.end() || it->second != gen)
+		EntitySlot *slot = entities.find(entity);
+		if (!slot)
 			return;
 
 		/* remove all components */
-		if (const auto record_it = entity_records.find(entity_id);
-			record_it != entity_records.end())
+		if (Archetype *archetype = slot->record.archetype)
 		{
-			Record &record = record_it->second;
-			Archetype *archetype = record.archetype;
-			const size_t row = record.row;
+			const size_t row = slot->record.row;
 
 			/* first call destructors for non-trivial components */
-			for (Component comp_id: archetype->components)
+			for (Column &column: archetype->columns)
 			{
-				if (auto destructor_it = cdtors.find(comp_id);
-					destructor_it != cdtors.end())
-				{
-					const Column &column = archetype->columns[comp_id];
-					void *component_ptr = static_cast<char *>(column.data) + (row * column.size);
-					destructor_it->second(component_ptr); /* call ~T() */
-				}
+				if (const auto destroy = types[column.id].destroy)
+					destroy(column.at(row)); /* call ~T() */
 			}
 
-			archetype->remove(entity_id) ;/* remove the archetype; note that this cleans up the memory as well */
-			entity_records.erase(entity_id); /* clear the record */
+			detach(archetype, row); /* remove the archetype; note that this cleans up the memory as well */
+
+			/* value ids sort between type ids and pair ids */
+			for (auto it = std::ranges::lower_bound(archetype->components, SHARED_FLAG);
+			     it != archetype->components.end() && *it < PAIR_FLAG; ++it)
+				release_shared(*it);
 		}
 
-		const auto idx_it = entity_indices.find(entity_id);
-		if (idx_it == entity_indices.end())
-			return;
+		entities.destroy(entity); /* bumps the generation and recycles the id */
+		if (journal)
+			journal->despawned(entity);
+		release_pairs(entity);
+	}
 
-		if (const size_t index = idx_it->second;
-			index < alive_count - 1)
-		{
-			entity_pool[index] = entity_pool[alive_count - 1];
-			entity_indices[entity_pool[index]] = index;
-		}
+	bool World::alive(const Entity entity) const
+	{
+		return entities.find(entity) != nullptr;
+	}
 
-		entity_pool[alive_count - 1] = entity_id;
-		--alive_count;
+	Tick World::tick() const
+	{
+		return current_tick;
+	}
 
-		/* update generation for reuse */
-		generations[entity_id] = (generations[entity_id] + 1) > MAX_GENERATION ? 0 : generations[entity_id] + 1;
-		entity_indices.erase(entity_id); /* clean up entity index */
+	Tick World::advance()
+	{
+		return ++current_tick;
+	}
+
+	void World::mark_changed(const Entity entity, const Component component)
+	{
+		const EntitySlot *slot = entities.find(entity);
+		if (!slot || !slot->record.archetype)
+			return;
+
+		if (Column *column = slot->record.archetype->column(component))
+			column->mark_changed(slot->record.row, current_tick);
 	}
 
 	Entity World::encode_entity(const uint64_t id, const Generation gen)
@@ -138,124 +165,611 @@ namespace ncs
 		std::vector<Component> sorted_components = components;
 		std::ranges::sort(sorted_components);
 
-		const uint64_t hash = archash(sorted_components);
-		if (const auto it = archetypes.find(hash);
-			it != archetypes.end())
-			return it->second;
+		Signature signature(sorted_components);
+		if (Archetype *existing = lookup_archetype(signature))
+			return existing;
 
 		auto *archetype = new Archetype();
+		archetype->storage = storage;
 		archetype->components = sorted_components;
-		archetype->id = hash;
+		archetype->id = signature.hash();
+		archetype->signature = std::move(signature);
+		archetype->index = static_cast<uint32_t>(archetypes.size());
 
 		for (Component comp_id: sorted_components)
 		{
-			Column column = {};
-			column.size = component_sizes[comp_id];
-			archetype->columns[comp_id] = column;
+			if (comp_id & PAIR_FLAG) /* pairs are tags; they only feed the reverse index */
+			{
+				if (const Component index = comp_id & ~PAIR_FLAG;
+					index < pairs.size())
+					pairs[index].archetypes.emplace_back(archetype);
+				continue;
+			}
+
+			if (comp_id & SHARED_FLAG) /* the value is kept once by the world; rows only reference it */
+				continue;
+
+			if (comp_id >= types.size())
+				types.resize(comp_id + 1);
+
+			const TypeInfo &info = types[comp_id];
+			if (info.size == 0) /* tags are part of the signature only */
+				continue;
+
+			Column &column = archetype->add_column(comp_id);
+			column.size = info.size;
+			column.relocate_fn = info.relocate;
+		}
+
+		archetypes.emplace_back(archetype);
+		archetype_ids.emplace(archetype->id, archetype->index);
+
+		/* patch every cached query this archetype satisfies */
+		for (auto &[qhash, state]: qcaches)
+		{
+			if (state->matches(archetype->signature))
+				state->archetypes.emplace_back(archetype);
 		}
 
-		archetypes[hash] = archetype;
 		return archetype;
 	}
 
+	QueryState *World::query_state(const Signature &mask, const Signature &exclude, std::vector<Signature> any)
+	{
+		/* signatures are order-free already; Or groups are put in a canonical order too */
+		std::ranges::sort(any, {}, &Signature::hash);
+
+		uint64_t qhash = mask.hash() ^ std::rotl(exclude.hash(), 21);
+		for (const Signature &group: any)
+			qhash = std::rotl(qhash, 7) ^ group.hash();
+
+		const auto [first, last] = qcaches.equal_range(qhash);
+		for (auto it = first; it != last; ++it)
+		{
+			if (const QueryState *state = it->second;
+				state->mask == mask && state->exclude == exclude && state->any == any)
+				return it->second;
+		}
+
+		/* first use; scan once, create_archetype keeps the list current afterwards */
+		auto *state = new QueryState();
+		state->mask = mask;
+		state->exclude = exclude;
+		state->any = std::move(any);
+
+		for (Archetype *arch: archetypes)
+		{
+			if (state->matches(arch->signature))
+				state->archetypes.emplace_back(arch);
+		}
+
+		qcaches.emplace(qhash, state);
+		return state;
+	}
+
 	Archetype *World::find_archetype_with(Archetype *source, const Component component)
 	{
-		if (const auto edge_it = source->add_edge.find(component);
-			edge_it != source->add_edge.end() && edge_it->second->to != nullptr)
-			return edge_it->second->to;
+		if (const uint32_t to = source->add_edge.find(component);
+			to != EdgeTable::NONE)
+			return archetypes[to];
 
 		if (source->has(component))
 			return source;
 
-		std::vector<Component> new_components = source->components;
-		new_components.emplace_back(component);
-		Archetype *target = find_archetype(new_components);
-		if (!target)
-			target = create_archetype(new_components);
+		/* source's ids are sorted already; the new one is inserted in place */
+		const auto build = [this, source, component](const std::span<Component> ids)
+		{
+			const auto at = std::ranges::lower_bound(source->components, component);
+			auto out = std::copy(source->components.begin(), at, ids.begin());
+			*out++ = component;
+			std::copy(at, source->components.end(), out);
+			return intern_archetype(ids);
+		};
 
-		/* cache the edge for O(1) move */
-		auto *edge = new GraphEdge();
-		edge->from = source;
-		edge->to = target;
-		edge->id = component;
+		Archetype *target = with_scratch<SCRATCH_COMPONENTS>(source->components.size() + 1, build);
 
-		source->add_edge[component] = edge;
+		/* cache the edge for O(1) move */
+		source->add_edge.insert(component, target->index);
 		return target;
 	}
 
 	Archetype *World::find_archetype(const std::vector<Component> &components)
 	{
-		std::vector<Component> sorted_components = components;
-		std::ranges::sort(sorted_components);
-
-		const uint64_t hash = archash(sorted_components);
-		if (const auto it = archetypes.find(hash);
-			it != archetypes.end())
-			return it->second;
-
-		return nullptr;
+		return lookup_archetype(Signature(components));
 	}
 
 	Archetype *World::find_archetype_without(Archetype *source, const Component component)
 	{
-		if (const auto edge_it = source->remove_edge.find(component);
-			edge_it != source->remove_edge.end() && edge_it->second->to != nullptr)
-			return edge_it->second->to;
+		if (const uint32_t to = source->remove_edge.find(component);
+			to != EdgeTable::NONE)
+			return archetypes[to];
 
 		if (!source->has(component))
 			return source;
 
-		/* create new component list */
-		std::vector<Component> new_components;
-		new_components.reserve(source->components.size() - 1);
-		for (Component c: source->components)
+		const auto build = [this, source, component](const std::span<Component> ids)
 		{
-			if (c != component)
-				new_components.emplace_back(c);
-		}
+			std::ranges::remove_copy(source->components, ids.begin(), component);
+			return intern_archetype(ids);
+		};
 
-		Archetype *target = find_archetype(new_components);
-		if (!target)
-			target = create_archetype(new_components);
+		Archetype *target = with_scratch<SCRATCH_COMPONENTS>(source->components.size() - 1, build);
 
 		/* cache the edge for future use*/
-		auto *edge = new GraphEdge();
-		edge->from = source;
-		edge->to = target;
-		edge->id = component;
-
-		source->remove_edge[component] = edge;
+		source->remove_edge.insert(component, target->index);
 		return target;
 	}
 
+	Archetype *World::lookup_archetype(const Signature &signature) const
+	{
+		/* the full signature is compared; a hash collision never hands out the wrong archetype */
+		const auto [first, last] = archetype_ids.equal_range(signature.hash());
+		for (auto it = first; it != last; ++it)
+		{
+			if (archetypes[it->second]->signature == signature)
+				return archetypes[it->second];
+		}
+
+		return nullptr;
+	}
+
+	Archetype *World::intern_archetype(const std::span<const Component> sorted)
+	{
+		if (Archetype *archetype = lookup_archetype(Signature(sorted)))
+			return archetype;
+
+		return create_archetype(std::vector(sorted.begin(), sorted.end()));
+	}
+
+	Archetype *World::find_archetype_delta(Archetype *source, const std::span<const Component> add,
+	                                       const std::span<const Component> remove)
+	{
+		/* the final ids; sorted, so the result is the same whichever way the delta is built */
+		const auto build = [this, source, add, remove](const std::span<Component> ids)
+		{
+			size_t count = 0;
+			for (const Component c: source->components)
+			{
+				if (std::ranges::find(remove, c) == remove.end())
+					ids[count++] = c;
+			}
+
+			for (const Component c: add)
+			{
+				if (const auto kept = ids.first(count);
+					std::ranges::find(kept, c) == kept.end())
+					ids[count++] = c;
+			}
+
+			std::ranges::sort(ids.first(count));
+			return intern_archetype(ids.first(count));
+		};
+
+		/* set<A, B> and set<B, A> share an edge */
+		const auto resolve = [source, add, remove, &build](const std::span<Component> delta)
+		{
+			const auto split = std::ranges::copy(add, delta.begin()).out;
+			*split = DELTA_SEPARATOR;
+			std::ranges::copy(remove, split + 1);
+			std::sort(delta.begin(), split);
+			std::sort(split + 1, delta.end());
+
+			const uint64_t hash = archash(delta);
+			if (const auto it = source->bundle_edge.find(hash);
+				it != source->bundle_edge.end() && std::ranges::equal(it->second.delta, delta))
+				return it->second.to;
+
+			Archetype *target = with_scratch<SCRATCH_COMPONENTS>(source->components.size() + add.size(), build);
+			source->bundle_edge[hash] = { std::vector(delta.begin(), delta.end()), target };
+			return target;
+		};
+
+		return with_scratch<SCRATCH_COMPONENTS>(add.size() + 1 + remove.size(), resolve);
+	}
+
 	void World::move_entity(const Entity entity, Record &record, Archetype *destination)
 	{
-		const uint64_t entity_id = get_eid(entity);
 		Archetype *source = record.archetype;
 		if (source == destination)
 			return;
 
 		const size_t src_row = record.row;
-		const size_t dest_row = destination->append(entity_id);
-		for (Component comp: source->components)
+		const size_t dest_row = destination->append(entity);
+		for (Column &dst_col: destination->columns)
 		{
-			if (destination->has(comp))
+			/* carried over components keep their ticks; new ones are being added now */
+			if (const Column *src_col = source->column(dst_col.id))
 			{
-				const Column &src_col = source->columns[comp];
-				const Column &dst_col = destination->columns[comp];
-
-				memcpy(
-					static_cast<char *>(dst_col.data) + (dest_row * dst_col.size),
-					static_cast<char *>(src_col.data) + (src_row * src_col.size),
-					src_col.size
-				);
+				src_col->relocate(dst_col.at(dest_row), src_col->at(src_row));
+				dst_col.copy_ticks(dest_row, *src_col, src_row);
+			}
+			else
+			{
+				dst_col.mark_added(dest_row, current_tick);
 			}
 		}
 
 		/* patch */
-		source->remove(entity_id);
+		detach(source, src_row);
 		record.archetype = destination;
 		record.row = dest_row;
-		entity_records[entity_id] = record;
+		moved(entity, destination);
+	}
+
+	void World::move_batch(Archetype *source, Archetype *destination, const std::span<const Entity> batch)
+	{
+		if (source == destination || batch.empty())
+			return;
+
+		/* one growth for the whole batch; append below never reallocates */
+		const size_t base = destination->entity_count;
+		destination->reserve(base + batch.size());
+
+		std::vector<size_t> rows(batch.size());
+		for (size_t i = 0; i < batch.size(); ++i)
+		{
+			rows[i] = entities.find(batch[i])->record.row;
+			destination->append(batch[i]);
+		}
+
+		if (source)
+		{
+			/* column at a time so each pair of columns streams through the cache once */
+			for (const Column &src_col: source->columns)
+			{
+				if (Column *dst_col = destination->column(src_col.id))
+				{
+					for (size_t i = 0; i < batch.size(); ++i)
+					{
+						src_col.relocate(dst_col->at(base + i), src_col.at(rows[i]));
+						dst_col->copy_ticks(base + i, src_col, rows[i]);
+					}
+				}
+				else if (const auto destroy = types[src_col.id].destroy)
+				{
+					for (size_t i = 0; i < batch.size(); ++i)
+						destroy(src_col.at(rows[i]));
+				}
+			}
+
+			/* highest row first; the row swapped in from the end then never belongs to the batch */
+			std::vector<size_t> order(batch.size());
+			for (size_t i = 0; i < order.size(); ++i)
+				order[i] = i;
+			std::ranges::sort(order, std::greater {}, [&rows](const size_t i) { return rows[i]; });
+			for (const size_t i: order)
+				detach(source, rows[i]);
+		}
+
+		/* columns the source lacks are about to be written by the caller */
+		for (Column &dst_col: destination->columns)
+		{
+			if (source && source->column(dst_col.id))
+				continue;
+
+			for (size_t i = 0; i < batch.size(); ++i)
+				dst_col.mark_added(base + i, current_tick);
+		}
+
+		for (size_t i = 0; i < batch.size(); ++i)
+		{
+			entities.find(batch[i])->record = { destination, base + i };
+			moved(batch[i], destination);
+		}
+	}
+
+	Archetype *World::archetype_of(const Entity entity) const
+	{
+		const EntitySlot *slot = entities.find(entity);
+		return slot ? slot->record.archetype : nullptr;
+	}
+
+	void *World::component_ptr(const Entity entity, const Component component) const
+	{
+		const EntitySlot *slot = entities.find(entity);
+		if (!slot || !slot->record.archetype)
+			return nullptr;
+
+		const Column *column = slot->record.archetype->column(component);
+		return column ? column->at(slot->record.row) : nullptr;
+	}
+
+	const Record *World::record_of(const Entity entity) const
+	{
+		const EntitySlot *slot = entities.find(entity);
+		return slot ? &slot->record : nullptr;
+	}
+
+	std::pair<Component, Entity> World::pair_of(const Component id) const
+	{
+		const PairRecord &record = pairs[id & ~PAIR_FLAG];
+		return { record.relation, record.target };
+	}
+
+	std::pair<void *, bool> World::acquire(const Entity entity, Record &record, const Component component)
+	{
+		Archetype *current = record.archetype;
+		const bool exists = current && current->has(component);
+		if (current == nullptr) /* entity doesn't exist in any archetype yet; start from the root */
+		{
+			Archetype *dst = find_archetype_with(root_archetype, component);
+			record = { dst, dst->append(entity) }; /* archetypes keep full handles */
+			for (Column &column: dst->columns)
+				column.mark_added(record.row, current_tick);
+			moved(entity, dst);
+		}
+		else if (!exists)
+		{
+			move_entity(entity, record, find_archetype_with(current, component));
+		}
+		else
+		{
+			current->flags |= DirtyFlags::UPDATED;
+		}
+
+		return { touch(record, component), exists };
+	}
+
+	void World::transition(const Entity entity, Record &record, const std::span<const Component> add,
+	                       const std::span<const Component> remove)
+	{
+		Archetype *current = record.archetype;
+		if (current == nullptr)
+		{
+			Archetype *dst = find_archetype_delta(root_archetype, add, {});
+			if (dst == root_archetype)
+				return;
+
+			record = { dst, dst->append(entity) };
+			for (Column &column: dst->columns)
+				column.mark_added(record.row, current_tick);
+			moved(entity, dst);
+			return;
+		}
+
+		for (const Component c: remove)
+		{
+			/* only ids with a column have a type entry; tags and pairs have neither */
+			if (const Column *column = current->column(c);
+				column && types[c].destroy)
+				types[c].destroy(column->at(record.row));
+		}
+
+		Archetype *dst = find_archetype_delta(current, add, remove);
+		if (dst != current)
+			move_entity(entity, record, dst);
+		else if (!add.empty())
+			current->flags |= DirtyFlags::UPDATED;
+	}
+
+	void *World::touch(const Record &record, const Component component)
+	{
+		Column *column = record.archetype->column(component);
+		if (!column) /* tag */
+			return nullptr;
+
+		column->mark_changed(record.row, current_tick);
+		return column->at(record.row);
+	}
+
+	Component World::pair_id(const Component relation, const Entity target, const bool create)
+	{
+		std::vector<Component> *named = nullptr;
+		if (const auto it = targeted.find(target);
+			it != targeted.end())
+		{
+			/* a target is named by a handful of relations at most; a scan beats hashing the pair */
+			for (const Component id: it->second)
+			{
+				if (pairs[id & ~PAIR_FLAG].relation == relation)
+					return id;
+			}
+
+			named = &it->second;
+		}
+
+		if (!create)
+			return 0;
+
+		Component id;
+		if (!free_pairs.empty())
+		{
+			/* archetypes holding a freed id are empty; they simply stand for the new pair from now on */
+			id = free_pairs.back();
+			free_pairs.pop_back();
+		}
+		else
+		{
+			id = static_cast<Component>(pairs.size()) | PAIR_FLAG;
+			pairs.emplace_back();
+		}
+
+		PairRecord &record = pairs[id & ~PAIR_FLAG];
+		record.relation = relation;
+		record.target = target;
+		(named ? *named : targeted[target]).emplace_back(id);
+		return id;
+	}
+
+	void World::release_pairs(const Entity target)
+	{
+		const auto it = targeted.find(target);
+		if (it == targeted.end())
+			return;
+
+		const std::vector<Component> ids = std::move(it->second);
+		targeted.erase(it);
+
+		std::vector<Entity> batch;
+		for (const Component id: ids)
+		{
+			const size_t index = id & ~PAIR_FLAG;
+			for (size_t i = 0; i < pairs[index].archetypes.size(); ++i)
+			{
+				/* the holders move as one batch; the archetype they leave stays behind, empty */
+				Archetype *arch = pairs[index].archetypes[i];
+				if (arch->entity_count == 0)
+					continue;
+
+				batch.clear();
+				for (size_t row = 0, run; row < arch->entity_count; row += run)
+				{
+					run = arch->run(row);
+					batch.insert(batch.end(), arch->entity_at(row), arch->entity_at(row) + run);
+				}
+				move_batch(arch, find_archetype_without(arch, id), batch);
+			}
+
+			pairs[index].target = 0;
+			free_pairs.emplace_back(id);
+		}
+	}
+
+	Component World::shared_id(const Archetype *archetype, const Component type) const
+	{
+		for (auto it = std::ranges::lower_bound(archetype->components, SHARED_FLAG);
+		     it != archetype->components.end() && *it < PAIR_FLAG; ++it)
+		{
+			if (shared[*it & ~SHARED_FLAG].type == type)
+				return *it;
+		}
+
+		return 0;
+	}
+
+	void World::release_shared(const Component id)
+	{
+		SharedValue &value = shared[id & ~SHARED_FLAG];
+		if (--value.refs > 0)
+			return;
+
+		value.destroy(value.data);
+		std::erase(shared_ids[value.type], id);
+		value = {};
+		free_shared.emplace_back(id);
+	}
+
+	Component World::shared_type(const Component id) const
+	{
+		return shared[id & ~SHARED_FLAG].type;
+	}
+
+	size_t World::spawn_into(Archetype *archetype, const std::span<Entity> batch)
+	{
+		entities.create(batch);
+
+		const size_t base = archetype->append(batch);
+		for (size_t i = 0; i < batch.size(); ++i)
+		{
+			entities.slot(get_eid(batch[i]))->record = { archetype, base + i };
+			moved(batch[i], archetype);
+		}
+
+		for (Column &column: archetype->columns)
+		{
+			for (size_t i = 0; i < batch.size(); ++i)
+				column.mark_added(base + i, current_tick);
+		}
+
+		return base;
+	}
+
+	std::pair<Archetype *, size_t> World::stamp(Prefab &prefab, const std::span<Entity> batch)
+	{
+		Archetype *archetype = prefab.archetype();
+		const size_t base = spawn_into(archetype, batch);
+
+		/* whole runs per column; a contiguous archetype has a single run */
+		for (size_t row = base, run; row < base + batch.size(); row += run)
+		{
+			run = std::min(archetype->run(row), base + batch.size() - row);
+			prefab.fill(archetype, row, run);
+		}
+
+		for (const Component id: prefab.shared())
+			shared[id & ~SHARED_FLAG].refs += batch.size();
+
+		return { archetype, base };
+	}
+
+	void World::record(Journal *journal)
+	{
+		this->journal = journal;
+	}
+
+	void World::moved(const Entity entity, Archetype *archetype) const
+	{
+		if (journal) [[unlikely]]
+			journal->moved(entity, archetype);
+	}
+
+	void World::place(const Entity entity, Archetype *destination)
+	{
+		EntitySlot *slot = entities.find(entity);
+		if (!slot)
+			return;
+
+		Record &record = slot->record;
+		Archetype *source = record.archetype;
+		if (destination == root_archetype)
+			destination = nullptr;
+		if (source == destination)
+			return;
+
+		if (source)
+		{
+			for (Column &column: source->columns)
+			{
+				if ((!destination || !destination->column(column.id)) && types[column.id].destroy)
+					types[column.id].destroy(column.at(record.row));
+			}
+		}
+
+		if (!destination)
+		{
+			detach(source, record.row);
+			record = {};
+			moved(entity, nullptr);
+		}
+		else if (!source)
+		{
+			record = { destination, destination->append(entity) };
+			for (Column &column: destination->columns)
+				column.mark_added(record.row, current_tick);
+			moved(entity, destination);
+		}
+		else
+		{
+			move_entity(entity, record, destination);
+		}
+	}
+
+	std::span<Archetype *const> World::archetype_table() const
+	{
+		return archetypes;
+	}
+
+	std::span<const TypeInfo> World::type_table() const
+	{
+		return types;
+	}
+
+	const Column *World::column_of(const Archetype *archetype, const Component component)
+	{
+		return archetype->column(component);
+	}
+
+	void World::detach(Archetype *archetype, const size_t row)
+	{
+		const size_t last_row = archetype->entity_count - 1;
+		const Entity last = *archetype->entity_at(last_row);
+		archetype->remove(row);
+
+		/* swap-with-last moved the last entity into this row */
+		if (row == last_row)
+			return;
+
+		if (EntitySlot *slot = entities.slot(get_eid(last)))
+			slot->record.row = row;
 	}
 }
@@ -74,28 +74,28 @@ TEST_F(ArchetypeTest, EntityOperations)
 	EXPECT_EQ(row1, 0);
 	EXPECT_EQ(arch->entity_count, 1);
 	EXPECT_EQ(arch->entities[0], entity1);
-	EXPECT_EQ(arch->entity_rows[entity1], 0);
 
 	size_t row2 = arch->append(entity2);
 	EXPECT_EQ(row2, 1);
 	EXPECT_EQ(arch->entity_count, 2);
 	EXPECT_EQ(arch->entities[1], entity2);
-	EXPECT_EQ(arch->entity_rows[entity2], 1);
 
-	arch->remove(entity1);
+	/* the last row is swapped into the hole */
+	arch->remove(row1);
 	EXPECT_EQ(arch->entity_count, 1);
-	EXPECT_FALSE(arch->entity_rows.contains(entity1));
 	EXPECT_EQ(arch->entities[0], entity2);
-	EXPECT_EQ(arch->entity_rows[entity2], 0);
 
 	size_t row3 = arch->append(entity3);
 	EXPECT_EQ(row3, 1);
 	EXPECT_EQ(arch->entity_count, 2);
 	EXPECT_EQ(arch->entities[1], entity3);
 
-	arch->remove(entity3);
+	arch->remove(row3);
+	EXPECT_EQ(arch->entity_count, 1);
+	EXPECT_EQ(arch->entities[0], entity2);
+
+	arch->remove(5); /* out of range rows are ignored */
 	EXPECT_EQ(arch->entity_count, 1);
-	EXPECT_FALSE(arch->entity_rows.contains(entity3));
 }
 
 TEST_F(ArchetypeTest, ArchetypeTransitions)
@@ -127,6 +127,59 @@ TEST_F(ArchetypeTest, ArchetypeTransitions)
 	EXPECT_EQ(dest_rem, dest_rem2);
 }
 
+TEST_F(ArchetypeTest, SignatureHash)
+{
+	const ncs::Signature a(std::vector<ncs::Component> { 3, 70, 300 });
+	const ncs::Signature b(std::vector<ncs::Component> { 300, 3, 70 });
+	const ncs::Signature c(std::vector<ncs::Component> { 3, 71, 300 });
+	EXPECT_EQ(a, b);
+	EXPECT_EQ(a.hash(), b.hash());
+	EXPECT_NE(a.hash(), c.hash());
+	EXPECT_NE(ncs::Signature().hash(), a.hash());
+
+	/* the table is keyed by signature; order of the ids never matters */
+	ncs::Archetype *arch = world.create_archetype({ 300, 3, 70 });
+	EXPECT_EQ(world.find_archetype({ 70, 300, 3 }), arch);
+	EXPECT_EQ(world.find_archetype({ 3, 71, 300 }), nullptr);
+	EXPECT_EQ(arch->id, a.hash());
+}
+
+TEST_F(ArchetypeTest, EdgeTable)
+{
+	ncs::EdgeTable edges;
+	EXPECT_EQ(edges.find(1), ncs::EdgeTable::NONE);
+
+	/* enough edges to grow the table a few times */
+	for (ncs::Component c = 0; c < 300; ++c)
+		edges.insert(c * 7, c + 100);
+
+	for (ncs::Component c = 0; c < 300; ++c)
+		EXPECT_EQ(edges.find(c * 7), c + 100);
+	EXPECT_EQ(edges.find(1), ncs::EdgeTable::NONE);
+
+	edges.insert(7, 42); /* overwrites */
+	EXPECT_EQ(edges.find(7), 42);
+}
+
+TEST_F(ArchetypeTest, DenseIndices)
+{
+	ncs::Archetype *root = world.find_archetype({});
+	ASSERT_NE(root, nullptr);
+
+	/* one source with many outgoing edges; every destination keeps its own slot in the table */
+	std::vector<ncs::Archetype *> targets;
+	for (ncs::Component c = 1; c <= 100; ++c)
+		targets.emplace_back(world.find_archetype_with(root, c));
+
+	for (ncs::Component c = 1; c <= 100; ++c)
+	{
+		ncs::Archetype *target = targets[c - 1];
+		EXPECT_EQ(world.find_archetype_with(root, c), target);
+		EXPECT_EQ(world.find_archetype_without(target, c), root);
+		EXPECT_EQ(target->index, root->index + c);
+	}
+}
+
 TEST_F(ArchetypeTest, ArchetypeMovement)
 {
 	const std::vector<ncs::Component> comps1 = { 1, 2 };
@@ -138,21 +191,21 @@ TEST_F(ArchetypeTest, ArchetypeMovement)
 	constexpr auto size1 = sizeof(int);
 	constexpr auto size3 = sizeof(float);
 
-	source->columns[1].size = size1;
-	source->columns[1].resize(10);
-	source->columns[2].size = size1;
-	source->columns[2].resize(10);
+	source->add_column(1).size = size1;
+	source->add_column(2).size = size1;
+	dest->add_column(1).size = size1;
+	dest->add_column(3).size = size3;
 
-	dest->columns[1].size = size1;
-	dest->columns[1].resize(10);
-	dest->columns[3].size = size3;
-	dest->columns[3].resize(10);
+	for (ncs::Column &column: source->columns)
+		column.resize(10);
+	for (ncs::Column &column: dest->columns)
+		column.resize(10);
 
 	constexpr ncs::Entity entity = 1;
 	const size_t row = source->append(entity);
 
-	const auto data1 = static_cast<int *>(source->columns[1].get(row));
-	const auto data2 = static_cast<int *>(source->columns[2].get(row));
+	const auto data1 = static_cast<int *>(source->column(1)->get(row));
+	const auto data2 = static_cast<int *>(source->column(2)->get(row));
 	*data1 = 42;
 	*data2 = 99;
 
@@ -164,11 +217,196 @@ TEST_F(ArchetypeTest, ArchetypeMovement)
 
 	EXPECT_EQ(source->entity_count, 0);
 	EXPECT_EQ(dest->entity_count, 1);
-	EXPECT_FALSE(source->entity_rows.contains(entity));
-	EXPECT_TRUE(dest->entity_rows.contains(entity));
 	EXPECT_EQ(record.archetype, dest);
+	EXPECT_EQ(dest->entities[record.row], entity);
 
-	const int *dest_data1 = static_cast<int *>(dest->columns[1].get(record.row));
+	const int *dest_data1 = static_cast<int *>(dest->column(1)->get(record.row));
 	EXPECT_EQ(*dest_data1, 42);
 }
 
+
+TEST_F(ArchetypeTest, SignatureOverflow)
+{
+	/* ids past the inline bitset take the overflow path */
+	const std::vector<ncs::Component> components = { 2, 255, 256, 1000 };
+	ncs::Archetype *arch = world.create_archetype(components);
+
+	for (const ncs::Component c: components)
+		EXPECT_TRUE(arch->has(c));
+
+	EXPECT_FALSE(arch->has(0));
+	EXPECT_FALSE(arch->has(257));
+	EXPECT_FALSE(arch->has(999));
+
+	const ncs::Signature inline_mask(std::vector<ncs::Component> { 2, 255 });
+	const ncs::Signature overflow_mask(std::vector<ncs::Component> { 2, 1000 });
+	const ncs::Signature missing_mask(std::vector<ncs::Component> { 2, 1001 });
+	EXPECT_TRUE(arch->signature.contains(inline_mask));
+	EXPECT_TRUE(arch->signature.contains(overflow_mask));
+	EXPECT_FALSE(arch->signature.contains(missing_mask));
+	EXPECT_TRUE(arch->signature.intersects(missing_mask));
+
+	ncs::Archetype *without = world.find_archetype_without(arch, 1000);
+	EXPECT_TRUE(without->has(256));
+	EXPECT_FALSE(without->has(1000));
+	EXPECT_FALSE(without->signature.contains(overflow_mask));
+}
+
+TEST(ChunkedStorageTest, PointerStability)
+{
+	ncs::World world(ncs::Storage::CHUNKED);
+
+	const auto first = world.entity();
+	world.set<Position>(first, Position { 1.0f, 2.0f, 3.0f });
+	world.set<Velocity>(first, Velocity { 4.0f, 5.0f, 6.0f });
+	const Position *pos = world.get<Position>(first);
+	const ncs::Archetype *arch = world.archetype_of(first);
+	const ncs::Entity *handle = arch->entity_at(0);
+
+	/* many chunks worth of rows; the first row must never move */
+	for (auto i = 0; i < 10000; ++i)
+	{
+		const auto e = world.entity();
+		world.set<Position>(e, Position { static_cast<float>(i), 0.0f, 0.0f });
+		world.set<Velocity>(e, Velocity { 0.0f, static_cast<float>(i), 0.0f });
+	}
+
+	/* the handles live in the chunks too; growth allocated chunks and copied nothing */
+	EXPECT_EQ(arch->entity_at(0), handle);
+	EXPECT_EQ(*handle, first);
+	EXPECT_TRUE(arch->entities.empty());
+	EXPECT_EQ(arch->capacity, arch->chunks.size() * arch->chunk_rows);
+	EXPECT_EQ(world.get<Position>(first), pos);
+	EXPECT_EQ(pos->x, 1.0f);
+	EXPECT_EQ(world.get<Velocity>(first)->z, 6.0f);
+
+	/* so do the change ticks; no per-row vector is left to double */
+	for (const ncs::Column &column: arch->columns)
+		EXPECT_TRUE(column.added_ticks.empty() && column.changed_ticks.empty());
+
+	world.advance();
+	world.mark_changed<Position>(first);
+	size_t changed = 0;
+	world.each<ncs::Changed<Position> >([&](const ncs::Entity e, const Position &)
+	{
+		EXPECT_EQ(e, first);
+		++changed;
+	});
+	EXPECT_EQ(changed, 1);
+}
+
+TEST(ChunkedStorageTest, IterationAndRemoval)
+{
+	ncs::World world(ncs::Storage::CHUNKED);
+
+	std::vector<ncs::Entity> entities;
+	for (auto i = 0; i < 5000; ++i)
+	{
+		const auto e = world.entity();
+		world.set<Position>(e, Position { static_cast<float>(i), 0.0f, 0.0f });
+		world.set<Health>(e, Health { i });
+		entities.emplace_back(e);
+	}
+
+	/* swap-remove across chunk boundaries */
+	for (auto i = 0; i < 5000; i += 3)
+		world.despawn(entities[i]);
+
+	size_t rows = 0;
+	size_t chunks = 0;
+	world.each_chunk<const Position, const Health>([&](const std::span<const ncs::Entity> ids,
+	                                                   const std::span<const Position> pos,
+	                                                   const std::span<const Health> health)
+	{
+		for (size_t i = 0; i < ids.size(); ++i)
+		{
+			EXPECT_EQ(static_cast<int>(pos[i].x), health[i].value);
+			EXPECT_EQ(world.get<Health>(ids[i]), &health[i]);
+		}
+
+		rows += ids.size();
+		++chunks;
+	});
+
+	EXPECT_EQ(rows, 5000 - 1667);
+	EXPECT_GT(chunks, 1);
+
+	for (auto i = 0; i < 5000; ++i)
+	{
+		if (i % 3 == 0)
+			continue;
+
+		ASSERT_NE(world.get<Health>(entities[i]), nullptr);
+		EXPECT_EQ(world.get<Health>(entities[i])->value, i);
+	}
+
+	/* moving out of a chunked archetype keeps the remaining rows intact */
+	for (auto i = 1; i < 5000; i += 3)
+		world.remove<Health>(entities[i]);
+
+	EXPECT_EQ((world.query<Position, Health>().size()), 5000 - 1667 - 1667);
+	EXPECT_EQ(world.query<Position>().size(), 5000 - 1667);
+}
+
+TEST_F(ArchetypeTest, TagsHaveNoColumn)
+{
+	const ncs::Entity e = world.entity();
+	world.set(e, Position { 1, 2, 3 })->set(e, Tag {});
+
+	const ncs::Component tag = world.component<Tag>();
+	ncs::Archetype *arch = world.find_archetype({ world.component<Position>(), tag });
+	ASSERT_NE(arch, nullptr);
+	EXPECT_TRUE(arch->has(tag));
+	EXPECT_EQ(arch->columns.size(), 1);
+	EXPECT_EQ(arch->column(tag), nullptr);
+
+	EXPECT_TRUE(world.has<Tag>(e));
+	EXPECT_NE(world.get<Tag>(e), nullptr);
+	EXPECT_EQ(world.get<Position>(e)->y, 2.0f);
+
+	size_t rows = 0;
+	world.each<Position, Tag>([&rows](const Position &p, const Tag &)
+	{
+		EXPECT_EQ(p.z, 3.0f);
+		++rows;
+	});
+	world.each_chunk<Position, Tag>([](const std::span<const ncs::Entity> entities, const std::span<Position> positions,
+	                                   const std::span<Tag> tags)
+	{
+		EXPECT_EQ(entities.size(), positions.size());
+		EXPECT_TRUE(tags.empty());
+	});
+	EXPECT_EQ(rows, 1);
+
+	world.remove<Tag>(e);
+	EXPECT_FALSE(world.has<Tag>(e));
+	EXPECT_EQ(world.get<Tag>(e), nullptr);
+	EXPECT_EQ(world.get<Position>(e)->x, 1.0f);
+}
+
+TEST(ChunkedStorageTest, Tags)
+{
+	ncs::World world(ncs::Storage::CHUNKED);
+
+	const auto tagged = world.spawn_batch<Tag>(5000, [](size_t, Tag &) {});
+	const auto mixed = world.spawn_batch<Position, Tag>(5000, [](const size_t i, Position &p, Tag &)
+	{
+		p.x = static_cast<float>(i);
+	});
+
+	size_t rows = 0;
+	world.each<Tag>([&rows](const Tag &) { ++rows; });
+	EXPECT_EQ(rows, 10000);
+
+	for (size_t i = 0; i < mixed.size(); i += 2)
+		world.remove<Tag>(mixed[i]);
+
+	for (size_t i = 0; i < mixed.size(); ++i)
+	{
+		EXPECT_EQ(world.get<Position>(mixed[i])->x, static_cast<float>(i));
+		EXPECT_EQ(world.has<Tag>(mixed[i]), i % 2 == 1);
+	}
+
+	world.despawn(tagged[0]);
+	EXPECT_EQ(world.get<Tag>(tagged[0]), nullptr);
+}
@@ -0,0 +1,236 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <string>
+#include <gtest/gtest.h>
+#include <ncs/sched/pool.hpp>
+#include <ncs/world/commands.hpp>
+#include <ncs/world/world.hpp>
+
+struct Position
+{
+	float x, y, z;
+};
+
+struct Velocity
+{
+	float x, y, z;
+};
+
+struct Health
+{
+	int value;
+};
+
+struct Name
+{
+	std::string name;
+};
+
+struct Counted
+{
+	static inline int moves = 0;
+	int value = 0;
+
+	Counted() = default;
+
+	Counted(Counted &&) noexcept
+	{
+		++moves;
+	}
+
+	Counted &operator=(Counted &&) noexcept = default;
+};
+
+TEST(CommandsTest, StructuralChangesDuringIteration)
+{
+	ncs::World world;
+	ncs::Commands commands(world);
+
+	std::vector<ncs::Entity> entities;
+	for (int i = 0; i < 100; ++i)
+	{
+		const ncs::Entity e = world.entity();
+		world.set(e, Position { static_cast<float>(i), 0, 0 });
+		world.set(e, Health { i });
+		entities.emplace_back(e);
+	}
+
+	world.each<Position, Health>([&commands](const ncs::Entity e, const Position &, const Health &h)
+	{
+		if (h.value % 3 == 0)
+			commands.despawn(e);
+		else if (h.value % 2 == 0)
+			commands.remove<Health>(e);
+		else
+			commands.set(e, Velocity { 1, 2, 3 });
+	});
+
+	/* nothing happens until apply */
+	for (const ncs::Entity e: entities)
+		EXPECT_TRUE(world.has<Health>(e));
+
+	commands.apply();
+
+	for (int i = 0; i < 100; ++i)
+	{
+		const ncs::Entity e = entities[i];
+		if (i % 3 == 0)
+		{
+			EXPECT_FALSE(world.alive(e));
+			continue;
+		}
+
+		ASSERT_NE(world.get<Position>(e), nullptr);
+		EXPECT_EQ(world.get<Position>(e)->x, static_cast<float>(i));
+		if (i % 2 == 0)
+		{
+			EXPECT_FALSE(world.has<Health>(e));
+			EXPECT_FALSE(world.has<Velocity>(e));
+		}
+		else
+		{
+			EXPECT_EQ(world.get<Health>(e)->value, i);
+			EXPECT_EQ(world.get<Velocity>(e)->y, 2.0f);
+		}
+	}
+
+	/* records must follow the batched moves */
+	size_t rows = 0;
+	world.each<Position>([&world, &rows](const ncs::Entity e, const Position &p)
+	{
+		EXPECT_EQ(world.get<Position>(e), &p);
+		++rows;
+	});
+	EXPECT_EQ(rows, 66);
+}
+
+TEST(CommandsTest, RecordFromThreads)
+{
+	ncs::World world;
+	ncs::ThreadPool pool(4);
+	ncs::Commands commands(world);
+
+	for (int i = 0; i < 5000; ++i)
+		world.set(world.entity(), Position { static_cast<float>(i), 0, 0 });
+
+	world.par_each<Position>(pool, [&commands](const ncs::Entity e, const Position &p)
+	{
+		commands.set(e, Velocity { p.x, 0, 0 });
+		commands.set(e, Name { std::to_string(static_cast<int>(p.x)) });
+	}, 64);
+
+	commands.apply();
+
+	size_t rows = 0;
+	world.each<Position, Velocity, Name>([&rows](const Position &p, const Velocity &v, const Name &n)
+	{
+		EXPECT_EQ(p.x, v.x);
+		EXPECT_EQ(n.name, std::to_string(static_cast<int>(p.x)));
+		++rows;
+	});
+	EXPECT_EQ(rows, 5000);
+}
+
+TEST(CommandsTest, LastWriteWins)
+{
+	ncs::World world;
+	ncs::Commands commands(world);
+
+	const ncs::Entity a = world.entity();
+	const ncs::Entity b = world.entity();
+	const ncs::Entity c = world.entity();
+	world.set(a, Name { "old" });
+
+	commands.set(a, Name { "first" }).set(a, Name { "second" });
+	commands.set(b, Name { "gone" }).remove<Name>(b);
+	commands.remove<Name>(a).set(a, Name { "third" });
+	commands.set(c, Health { 1 }).despawn(c);
+
+	/* lvalues are copied in, with or without an explicit type */
+	const Position at { 1, 2, 3 };
+	Health health { 5 };
+	commands.set<Position>(b, at).set<Health>(b, health).set(a, health);
+	commands.apply();
+	EXPECT_EQ(world.get<Position>(b)->z, 3.0f);
+	EXPECT_EQ(world.get<Health>(b)->value, 5);
+	EXPECT_EQ(world.get<Health>(a)->value, 5);
+
+	EXPECT_EQ(world.get<Name>(a)->name, "third");
+	EXPECT_FALSE(world.has<Name>(b));
+	EXPECT_TRUE(world.alive(b));
+	EXPECT_FALSE(world.alive(c));
+}
+
+TEST(CommandsTest, StaleHandlesAndClear)
+{
+	ncs::World world;
+	ncs::Commands commands(world);
+
+	const ncs::Entity e = world.entity();
+	commands.set(e, Name { "never applied" });
+	commands.clear();
+	commands.apply();
+	EXPECT_FALSE(world.has<Name>(e));
+
+	commands.set(e, Name { "stale" });
+	world.despawn(e);
+	commands.apply();
+	EXPECT_FALSE(world.alive(e));
+
+	/* pending values are released by the destructor */
+	commands.set(world.entity(), Name { "dropped" });
+}
+
+TEST(CommandsTest, ChunkedBatch)
+{
+	ncs::World world(ncs::Storage::CHUNKED);
+	ncs::Commands commands(world);
+
+	for (int i = 0; i < 3000; ++i)
+		world.set(world.entity(), Position { static_cast<float>(i), 0, 0 });
+
+	world.each<Position>([&commands](const ncs::Entity e, const Position &p)
+	{
+		commands.set(e, Health { static_cast<int>(p.x) });
+	});
+	commands.apply();
+
+	size_t rows = 0;
+	world.each<Position, Health>([&rows](const Position &p, const Health &h)
+	{
+		EXPECT_EQ(static_cast<int>(p.x), h.value);
+		++rows;
+	});
+	EXPECT_EQ(rows, 3000);
+}
+
+TEST(CommandsTest, DestinationGrowsOnce)
+{
+	ncs::World world;
+	ncs::Commands commands(world);
+
+	/* two source archetypes, one destination */
+	std::vector<ncs::Entity> left, right;
+	for (int i = 0; i < 100; ++i)
+	{
+		left.emplace_back(world.entity());
+		world.emplace<Counted>(left.back());
+		world.set(left.back(), Position { 0, 0, 0 });
+
+		right.emplace_back(world.entity());
+		world.emplace<Counted>(right.back());
+		world.set(right.back(), Velocity { 0, 0, 0 });
+	}
+
+	for (int i = 0; i < 100; ++i)
+	{
+		commands.set(left[i], Velocity { 1, 0, 0 });
+		commands.set(right[i], Position { 1, 0, 0 });
+	}
+
+	/* one relocation per entity into the destination; none for rows already there */
+	Counted::moves = 0;
+	commands.apply();
+	EXPECT_EQ(Counted::moves, 200);
+	EXPECT_EQ(world.archetype_of(left[0]), world.archetype_of(right[0]));
+}
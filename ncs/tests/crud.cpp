@@ -234,6 +234,28 @@ TEST_F(CRUDTest, MultipleEntities)
 	EXPECT_EQ(vel3->z, 60.0f);
 }
 
+TEST_F(CRUDTest, SwapRemoveKeepsRecords)
+{
+	const ncs::Entity entity2 = world.entity();
+	const ncs::Entity entity3 = world.entity();
+
+	world.set<Health>(entity, Health { 1 });
+	world.set<Health>(entity2, Health { 2 });
+	world.set<Health>(entity3, Health { 3 });
+
+	/* entity3 is swapped into entity's row */
+	world.despawn(entity);
+	ASSERT_NE(world.get<Health>(entity3), nullptr);
+	EXPECT_EQ(world.get<Health>(entity3)->value, 3);
+
+	/* entity3 is swapped again when entity2 moves to another archetype */
+	world.set<Position>(entity2, Position { 1.0f, 2.0f, 3.0f });
+	ASSERT_NE(world.get<Health>(entity2), nullptr);
+	ASSERT_NE(world.get<Health>(entity3), nullptr);
+	EXPECT_EQ(world.get<Health>(entity2)->value, 2);
+	EXPECT_EQ(world.get<Health>(entity3)->value, 3);
+}
+
 TEST_F(CRUDTest, NonTrivial)
 {
 	Name original("TestEntity");
@@ -281,4 +303,269 @@ TEST_F(CRUDTest, NonTrivial)
 
 	// world.despawn(entity);
 	// world.despawn(entity2);
-}
\ No newline at end of file
+}
+TEST_F(CRUDTest, SpawnBatch)
+{
+	world.set<Position>(entity, Position(-1, -1, -1))->set<Health>(entity, Health(-1));
+	world.despawn(entity); /* its id is recycled by the batch */
+
+	const auto batch = world.spawn_batch<Position, Health>(1000, [](const size_t i, Position &p, Health &h)
+	{
+		p.x = static_cast<float>(i);
+		h.value = static_cast<int>(i) * 2;
+	});
+
+	ASSERT_EQ(batch.size(), 1000);
+	EXPECT_EQ(ncs::World::get_eid(batch[0]), ncs::World::get_eid(entity));
+	EXPECT_NE(batch[0], entity);
+	for (size_t i = 0; i < batch.size(); ++i)
+	{
+		EXPECT_EQ(*world.get<Position>(batch[i]), Position(static_cast<float>(i)));
+		EXPECT_EQ(world.get<Health>(batch[i])->value, static_cast<int>(i) * 2);
+	}
+
+	/* batch entities behave like any other */
+	world.remove<Health>(batch[10]);
+	world.despawn(batch[20]);
+	EXPECT_FALSE(world.has<Health>(batch[10]));
+	EXPECT_EQ(*world.get<Position>(batch[999]), Position(999));
+	EXPECT_EQ(world.get<Health>(batch[999])->value, 1998);
+}
+
+TEST_F(CRUDTest, SpawnBatchFromSpans)
+{
+	ncs::World chunked(ncs::Storage::CHUNKED);
+
+	std::vector<Position> positions;
+	std::vector<Name> names;
+	for (int i = 0; i < 5000; ++i)
+	{
+		positions.emplace_back(static_cast<float>(i));
+		names.emplace_back(std::to_string(i));
+	}
+
+	const auto batch = chunked.spawn_batch<Position, Name>(positions, names);
+	ASSERT_EQ(batch.size(), 5000);
+	for (size_t i = 0; i < batch.size(); ++i)
+	{
+		EXPECT_EQ(*chunked.get<Position>(batch[i]), positions[i]);
+		EXPECT_EQ(chunked.get<Name>(batch[i])->name, names[i].name);
+	}
+
+	/* mismatched spans spawn nothing */
+	EXPECT_TRUE((world.spawn_batch<Position, Name>(positions, std::span(names).first(10)).empty()));
+
+	for (const ncs::Entity e: batch)
+		chunked.despawn(e);
+}
+
+/* counts live objects and checks that every object still sits at the address it knows about */
+struct Tracked
+{
+	static inline int live = 0;
+	Tracked *self;
+	int value;
+
+	explicit Tracked(const int value = 0) : self(this), value(value) { ++live; }
+
+	Tracked(const Tracked &other) : self(this), value(other.value) { ++live; }
+
+	Tracked(Tracked &&other) noexcept : self(this), value(other.value) { ++live; }
+
+	Tracked &operator=(const Tracked &other)
+	{
+		value = other.value;
+		return *this;
+	}
+
+	~Tracked()
+	{
+		EXPECT_EQ(self, this);
+		--live;
+	}
+
+	[[nodiscard]] bool valid() const
+	{
+		return self == this;
+	}
+};
+
+TEST(RelocationTest, NonTrivialComponentsSurviveMoves)
+{
+	{
+		ncs::World world;
+		std::vector<ncs::Entity> entities;
+		for (int i = 0; i < 300; ++i) /* enough rows to grow every column a few times */
+		{
+			const ncs::Entity e = world.entity();
+			world.set(e, Tracked(i))->set(e, Name("entity " + std::to_string(i)));
+			entities.emplace_back(e);
+		}
+
+		/* swap-removes from the middle and transitions to another archetype */
+		for (int i = 0; i < 300; i += 3)
+			world.despawn(entities[i]);
+		for (int i = 1; i < 300; i += 3)
+			world.set(entities[i], Health(i));
+		for (int i = 1; i < 300; i += 6)
+			world.remove<Name>(entities[i]);
+
+		for (int i = 0; i < 300; ++i)
+		{
+			if (i % 3 == 0)
+				continue;
+
+			const Tracked *t = world.get<Tracked>(entities[i]);
+			ASSERT_NE(t, nullptr);
+			EXPECT_TRUE(t->valid());
+			EXPECT_EQ(t->value, i);
+			if (i % 6 != 1)
+			{
+				EXPECT_EQ(world.get<Name>(entities[i])->name, "entity " + std::to_string(i));
+			}
+		}
+
+		EXPECT_EQ(Tracked::live, 200);
+	}
+
+	/* the world destroys whatever is left */
+	EXPECT_EQ(Tracked::live, 0);
+}
+
+TEST(RelocationTest, ChunkedStorage)
+{
+	{
+		ncs::World world(ncs::Storage::CHUNKED);
+		const auto batch = world.spawn_batch<Tracked, Name>(2000, [](const size_t i, Tracked &t, Name &n)
+		{
+			t.value = static_cast<int>(i);
+			n.name = std::to_string(i);
+		});
+
+		for (size_t i = 0; i < batch.size(); i += 2)
+			world.remove<Name>(batch[i]);
+		for (size_t i = 1; i < batch.size(); i += 4)
+			world.despawn(batch[i]);
+
+		size_t rows = 0;
+		world.each<Tracked>([&rows](const Tracked &t)
+		{
+			EXPECT_TRUE(t.valid());
+			++rows;
+		});
+		EXPECT_EQ(rows, 1500);
+		EXPECT_EQ(Tracked::live, 1500);
+	}
+
+	EXPECT_EQ(Tracked::live, 0);
+}
+
+/* counts copies so writes that should move or construct in place can be checked */
+struct Path
+{
+	static inline int copies = 0;
+	std::vector<int> points;
+
+	Path() = default;
+
+	explicit Path(const size_t n, const int v) : points(n, v) {}
+
+	Path(const Path &other) : points(other.points) { ++copies; }
+
+	Path(Path &&other) noexcept = default;
+
+	Path &operator=(const Path &other)
+	{
+		points = other.points;
+		++copies;
+		return *this;
+	}
+
+	Path &operator=(Path &&other) noexcept = default;
+};
+
+TEST_F(CRUDTest, EmplaceAndMove)
+{
+	Path::copies = 0;
+
+	/* constructed straight in the column */
+	Path *path = world.emplace<Path>(entity, 16, 7);
+	ASSERT_NE(path, nullptr);
+	EXPECT_EQ(world.get<Path>(entity), path);
+	EXPECT_EQ(path->points.size(), 16);
+
+	/* moving an existing value in keeps the source's buffer */
+	Path incoming(32, 1);
+	const int *buffer = incoming.points.data();
+	world.set(entity, std::move(incoming));
+	EXPECT_EQ(world.get<Path>(entity)->points.data(), buffer);
+
+	/* moving into a new archetype and growing it never copies */
+	for (int i = 0; i < 100; ++i)
+	{
+		const ncs::Entity e = world.entity();
+		world.set(e, Health(i));
+		world.set(e, Path(4, i));
+	}
+	world.emplace<Health>(entity, 5);
+	EXPECT_EQ(world.get<Health>(entity)->value, 5);
+	EXPECT_EQ(world.get<Path>(entity)->points.data(), buffer);
+	EXPECT_EQ(Path::copies, 0);
+
+	/* lvalue writes still copy, assigning over the current value */
+	const Path local(2, 9);
+	world.set(entity, local);
+	EXPECT_EQ(Path::copies, 1);
+	EXPECT_EQ(world.get<Path>(entity)->points, local.points);
+
+	/* replacing from the current value reads it before it is destroyed */
+	world.emplace<Path>(entity, *world.get<Path>(entity));
+	EXPECT_EQ(world.get<Path>(entity)->points, local.points);
+
+	EXPECT_EQ(world.emplace<Path>(world.encode_entity(12345, 0), 1, 1), nullptr);
+}
+
+TEST_F(CRUDTest, Bundles)
+{
+	world.set(entity, Position(1, 2, 3), Velocity(4, 5, 6), Name("bundle"));
+	EXPECT_EQ(*world.get<Position>(entity), Position(1, 2, 3));
+	EXPECT_EQ(*world.get<Velocity>(entity), Velocity(4, 5, 6));
+	EXPECT_EQ(world.get<Name>(entity)->name, "bundle");
+
+	/* straight to the final archetype; nothing in between is created */
+	const ncs::Component p = world.component<Position>();
+	const ncs::Component v = world.component<Velocity>();
+	const ncs::Component n = world.component<Name>();
+	EXPECT_EQ(world.find_archetype({ p }), nullptr);
+	EXPECT_EQ(world.find_archetype({ p, v }), nullptr);
+
+	/* the edge is cached regardless of order */
+	ncs::Archetype *root = world.find_archetype({});
+	const ncs::Component forward[] = { p, v, n };
+	const ncs::Component backward[] = { n, v, p };
+	EXPECT_EQ(world.find_archetype_delta(root, forward, {}), world.archetype_of(entity));
+	EXPECT_EQ(world.find_archetype_delta(root, backward, {}), world.archetype_of(entity));
+
+	/* existing components are overwritten in place, new ones added in the same move */
+	world.set<Name, Health>(entity, Name("again"), Health(7));
+	EXPECT_EQ(world.get<Name>(entity)->name, "again");
+	EXPECT_EQ(world.get<Health>(entity)->value, 7);
+	EXPECT_EQ(world.find_archetype({ p, v, n, world.component<Health>() }), world.archetype_of(entity));
+
+	world.remove<Position, Name>(entity);
+	EXPECT_FALSE(world.has<Position>(entity));
+	EXPECT_FALSE(world.has<Name>(entity));
+	EXPECT_EQ(*world.get<Velocity>(entity), Velocity(4, 5, 6));
+	EXPECT_EQ(world.get<Health>(entity)->value, 7);
+	EXPECT_EQ(world.find_archetype({ v, n, world.component<Health>() }), nullptr);
+
+	world.replace<Velocity>(entity, Name("replaced"));
+	EXPECT_FALSE(world.has<Velocity>(entity));
+	EXPECT_EQ(world.get<Name>(entity)->name, "replaced");
+	EXPECT_EQ(world.get<Health>(entity)->value, 7);
+
+	/* removing what isn't there is a no-op */
+	ncs::Archetype *before = world.archetype_of(entity);
+	world.remove<Position, Velocity>(entity);
+	EXPECT_EQ(world.archetype_of(entity), before);
+}
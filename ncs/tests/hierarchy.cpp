@@ -0,0 +1,117 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <gtest/gtest.h>
+#include <ncs/world/hierarchy.hpp>
+#include <ncs/world/world.hpp>
+
+/* 1d offsets keep the arithmetic exact */
+struct Local
+{
+	float offset;
+};
+
+struct Global
+{
+	float offset;
+};
+
+static Global compose(const Global *parent, const Local &local)
+{
+	return { (parent ? parent->offset : 0.0f) + local.offset };
+}
+
+class HierarchyTest : public testing::Test
+{
+protected:
+	ncs::World world;
+	ncs::Hierarchy<Local, Global> hierarchy { world };
+
+	ncs::Entity node(const float offset, const ncs::Entity parent = ~ncs::Entity { 0 })
+	{
+		const ncs::Entity e = world.entity();
+		world.set(e, Local { offset }, Global {});
+		if (parent != ~ncs::Entity { 0 })
+			world.add<ncs::ChildOf>(e, parent);
+		return e;
+	}
+
+	float global(const ncs::Entity e)
+	{
+		return world.get<Global>(e)->offset;
+	}
+};
+
+TEST_F(HierarchyTest, PropagatesDownChains)
+{
+	/* created children first so the archetype order is not already the depth order */
+	const ncs::Entity vehicle = world.entity();
+	const ncs::Entity turret = world.entity();
+	const ncs::Entity muzzle = node(1, turret);
+	world.set(turret, Local { 10 }, Global {});
+	world.add<ncs::ChildOf>(turret, vehicle);
+	world.set(vehicle, Local { 100 }, Global {});
+	const ncs::Entity other = node(1000);
+
+	EXPECT_EQ(hierarchy.propagate(compose), 4);
+	EXPECT_EQ(global(vehicle), 100);
+	EXPECT_EQ(global(turret), 110);
+	EXPECT_EQ(global(muzzle), 111);
+	EXPECT_EQ(global(other), 1000);
+
+	/* nothing changed in the next tick */
+	world.advance();
+	EXPECT_EQ(hierarchy.propagate(compose), 0);
+}
+
+TEST_F(HierarchyTest, OnlyDirtySubtrees)
+{
+	const ncs::Entity a = node(1);
+	const ncs::Entity b = node(2);
+	std::vector<ncs::Entity> under_a, under_b;
+	for (int i = 0; i < 4; ++i)
+	{
+		under_a.emplace_back(node(10, a));
+		under_b.emplace_back(node(20, b));
+	}
+	const ncs::Entity leaf = node(100, under_a[0]);
+	hierarchy.propagate(compose);
+
+	/* moving a drags its subtree along; b's stays untouched */
+	world.advance();
+	world.get<Local>(a)->offset = 5;
+	world.mark_changed<Local>(a);
+	EXPECT_EQ(hierarchy.propagate(compose), 1 + 4 + 1);
+	EXPECT_EQ(global(under_a[3]), 15);
+	EXPECT_EQ(global(leaf), 115);
+	EXPECT_EQ(global(under_b[0]), 22);
+
+	/* one leaf alone */
+	world.advance();
+	world.set(under_b[1], Local { 30 });
+	EXPECT_EQ(hierarchy.propagate(compose), 1);
+	EXPECT_EQ(global(under_b[1]), 32);
+}
+
+TEST_F(HierarchyTest, ReparentAndDespawn)
+{
+	const ncs::Entity a = node(1);
+	const ncs::Entity b = node(2);
+	const ncs::Entity child = node(10, a);
+	const ncs::Entity grandchild = node(100, child);
+	hierarchy.propagate(compose);
+	EXPECT_EQ(global(grandchild), 111);
+
+	world.advance();
+	world.remove<ncs::ChildOf>(child, a);
+	world.add<ncs::ChildOf>(child, b);
+	hierarchy.propagate(compose);
+	EXPECT_EQ(global(child), 12);
+	EXPECT_EQ(global(grandchild), 112);
+
+	/* a despawned parent leaves a root behind */
+	world.advance();
+	world.despawn(b);
+	hierarchy.propagate(compose);
+	EXPECT_EQ(global(child), 10);
+	EXPECT_EQ(global(grandchild), 110);
+}
@@ -0,0 +1,193 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <gtest/gtest.h>
+#include <ncs/world/journal.hpp>
+#include <ncs/world/world.hpp>
+
+struct Position
+{
+	float x, y, z;
+};
+
+struct Velocity
+{
+	float x, y, z;
+};
+
+struct Frozen {};
+
+struct Name
+{
+	std::string name;
+};
+
+static void prepare(ncs::World &world)
+{
+	world.component<Position>();
+	world.component<Velocity>();
+	world.component<Frozen>();
+}
+
+static void expect_same(ncs::World &world, ncs::World &replica, const ncs::Replay &replay,
+                        const std::vector<ncs::Entity> &handles)
+{
+	for (const ncs::Entity e: handles)
+	{
+		const ncs::Entity r = replay.entity(e);
+		ASSERT_EQ(world.alive(e), r != ncs::Replay::NONE && replica.alive(r));
+		if (!world.alive(e))
+			continue;
+
+		EXPECT_EQ(world.has<Frozen>(e), replica.has<Frozen>(r));
+		EXPECT_EQ(world.has<Velocity>(e), replica.has<Velocity>(r));
+		if (const Position *p = world.get<Position>(e))
+		{
+			ASSERT_NE(replica.get<Position>(r), nullptr);
+			EXPECT_EQ(replica.get<Position>(r)->x, p->x);
+			EXPECT_EQ(replica.get<Position>(r)->y, p->y);
+			EXPECT_EQ(replica.get<Position>(r)->z, p->z);
+		}
+		else
+		{
+			EXPECT_FALSE(replica.has<Position>(r));
+		}
+	}
+}
+
+TEST(JournalTest, ReplayFollowsEveryChange)
+{
+	ncs::World world;
+	std::vector<ncs::Entity> handles;
+	for (int i = 0; i < 100; ++i)
+	{
+		const ncs::Entity e = world.entity();
+		world.set(e, Position { static_cast<float>(i), 0, 0 });
+		handles.emplace_back(e);
+	}
+
+	/* entities from before the journal arrive with the first frame */
+	ncs::Journal journal(world);
+	ncs::World replica;
+	prepare(replica);
+	ncs::Replay replay(replica);
+
+	std::vector<std::byte> stream;
+	journal.commit(stream);
+	world.advance();
+
+	for (int i = 0; i < 100; i += 3)
+		world.set(handles[i], Velocity { 1, 0, 0 });
+	for (int i = 0; i < 100; i += 5)
+		world.remove<Position>(handles[i]);
+	for (int i = 1; i < 100; i += 11)
+		world.despawn(handles[i]);
+	world.set<Frozen>(handles[2], {});
+	world.get<Position>(handles[4])->y = 7;
+	world.mark_changed<Position>(handles[4]);
+
+	const ncs::Entity late = world.entity();
+	world.set(late, Position { 5, 6, 7 }, Velocity { 0, 0, 1 });
+	handles.emplace_back(late);
+	journal.commit(stream);
+	world.advance();
+
+	/* frames may be applied together or one at a time */
+	ASSERT_TRUE(replay.apply(stream));
+	expect_same(world, replica, replay, handles);
+	EXPECT_EQ(replay.tick(), world.tick() - 1);
+
+	/* nothing written, nothing but the header sent */
+	std::vector<std::byte> idle;
+	EXPECT_LT(journal.commit(idle), 8u);
+	ASSERT_TRUE(replay.apply(idle));
+
+	for (const ncs::Entity e: handles)
+	{
+		if (world.alive(e))
+			world.despawn(e);
+	}
+
+	std::vector<std::byte> last;
+	journal.commit(last);
+	ASSERT_TRUE(replay.apply(last));
+	expect_same(world, replica, replay, handles);
+	EXPECT_TRUE(replica.query<Position>().empty());
+}
+
+TEST(JournalTest, FramesAreSmallerThanSnapshots)
+{
+	const std::string path = testing::TempDir() + "ncs_journal.snapshot";
+	ncs::World world;
+	std::vector<ncs::Entity> handles(10000);
+	for (size_t i = 0; i < handles.size(); ++i)
+	{
+		handles[i] = world.entity();
+		world.set(handles[i], Position { static_cast<float>(i), 0, 0 }, Velocity { 1, 0, 0 });
+	}
+
+	ncs::Journal journal(world);
+	std::vector<std::byte> first;
+	journal.commit(first);
+	world.advance();
+
+	/* one row in a hundred moves a little */
+	for (size_t i = 0; i < handles.size(); i += 100)
+	{
+		world.get<Position>(handles[i])->x += 1;
+		world.mark_changed<Position>(handles[i]);
+	}
+
+	std::vector<std::byte> frame;
+	journal.commit(frame);
+	ASSERT_TRUE(world.save(path));
+	EXPECT_LT(frame.size() * 50, std::filesystem::file_size(path));
+	EXPECT_LT(first.size(), std::filesystem::file_size(path));
+
+	ncs::World replica;
+	prepare(replica);
+	ncs::Replay replay(replica);
+	ASSERT_TRUE(replay.apply(first));
+	ASSERT_TRUE(replay.apply(frame));
+	expect_same(world, replica, replay, handles);
+	std::remove(path.c_str());
+}
+
+TEST(JournalTest, Refusals)
+{
+	ncs::World world;
+	ncs::Journal journal(world);
+	const ncs::Entity e = world.entity();
+	world.set(e, Position { 1, 2, 3 }, Name { "left out" });
+
+	std::vector<std::byte> stream;
+	journal.commit(stream);
+
+	/* Name is not plain bytes and never leaves; Position must be known to the replica */
+	ncs::World unregistered;
+	unregistered.component<Velocity>();
+	EXPECT_FALSE(ncs::Replay(unregistered).apply(stream));
+
+	std::vector<std::byte> truncated(stream.begin(), stream.end() - 1);
+	ncs::World replica;
+	prepare(replica);
+	EXPECT_FALSE(ncs::Replay(replica).apply(truncated));
+
+	ncs::World whole;
+	prepare(whole);
+	ncs::Replay replay(whole);
+	ASSERT_TRUE(replay.apply(stream));
+	EXPECT_EQ(whole.get<Position>(replay.entity(e))->y, 2.0f);
+	EXPECT_FALSE(whole.has<Name>(replay.entity(e)));
+
+	/* a journal outliving its world stops quietly */
+	auto gone = std::make_unique<ncs::World>();
+	ncs::Journal orphan(*gone);
+	(void) gone->entity();
+	gone.reset();
+	std::vector<std::byte> empty;
+	EXPECT_GT(orphan.commit(empty), 0u);
+}
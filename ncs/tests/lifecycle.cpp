@@ -60,4 +60,53 @@ TEST_F(LifecycleTest, Respawn)
 
 	EXPECT_EQ(world.get_eid(reused), world.get_eid(e3));
 	EXPECT_NE(world.get_egen(reused), world.get_egen(e3));
-}
\ No newline at end of file
+}
+TEST_F(LifecycleTest, StaleHandle)
+{
+	const auto first = world.entity();
+	world.set<int>(first, 7);
+	world.despawn(first);
+
+	/* the id is recycled but the old handle must stay dead */
+	const auto recycled = world.entity();
+	world.set<int>(recycled, 42);
+
+	EXPECT_EQ(world.get<int>(first), nullptr);
+	EXPECT_FALSE(world.has<int>(first));
+	ASSERT_NE(world.get<int>(recycled), nullptr);
+	EXPECT_EQ(*world.get<int>(recycled), 42);
+
+	/* despawning a stale handle is a no-op */
+	world.despawn(first);
+	EXPECT_TRUE(world.has<int>(recycled));
+}
+
+TEST_F(LifecycleTest, PageBoundary)
+{
+	/* cross several table pages and recycle ids from all of them */
+	std::vector<ncs::Entity> entities;
+	for (auto i = 0; i < 10000; ++i)
+	{
+		const auto e = world.entity();
+		world.set<int>(e, i);
+		entities.emplace_back(e);
+	}
+
+	for (auto i = 0; i < 10000; i += 2)
+		world.despawn(entities[i]);
+
+	for (auto i = 1; i < 10000; i += 2)
+	{
+		const auto *value = world.get<int>(entities[i]);
+		ASSERT_NE(value, nullptr);
+		EXPECT_EQ(*value, i);
+	}
+
+	std::unordered_set<uint64_t> reused;
+	for (auto i = 0; i < 5000; ++i)
+		reused.insert(ncs::World::get_eid(world.entity()));
+
+	EXPECT_EQ(reused.size(), 5000);
+	for (const auto id : reused)
+		EXPECT_EQ(id % 2, 0); /* only despawned ids come back */
+}
@@ -0,0 +1,224 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <ncs/sched/pool.hpp>
+#include <ncs/sched/scheduler.hpp>
+#include <ncs/world/world.hpp>
+
+struct Position
+{
+	float x, y, z;
+};
+
+struct Velocity
+{
+	float x, y, z;
+};
+
+struct Health
+{
+	int value;
+};
+
+struct AI
+{
+	int state;
+};
+
+TEST(ThreadPoolTest, RunsEveryIndexOnce)
+{
+	ncs::ThreadPool pool(4);
+	EXPECT_EQ(pool.size(), 4);
+
+	std::vector<std::atomic<int> > hits(10000);
+	pool.run(hits.size(), [&hits](const size_t index)
+	{
+		hits[index].fetch_add(1);
+	});
+
+	for (const auto &hit: hits)
+		EXPECT_EQ(hit.load(), 1);
+}
+
+TEST(ThreadPoolTest, NestedRun)
+{
+	ncs::ThreadPool pool(4);
+
+	std::atomic<int> total = 0;
+	pool.run(8, [&pool, &total](size_t)
+	{
+		pool.run(100, [&total](size_t)
+		{
+			total.fetch_add(1);
+		});
+	});
+
+	EXPECT_EQ(total.load(), 800);
+}
+
+TEST(ThreadPoolTest, SingleThread)
+{
+	ncs::ThreadPool pool(1);
+
+	auto total = 0;
+	pool.run(100, [&total](const size_t index)
+	{
+		total += static_cast<int>(index);
+	});
+
+	EXPECT_EQ(total, 4950);
+}
+
+TEST(ParallelEachTest, VisitsEveryRow)
+{
+	ncs::World world;
+	for (auto i = 0; i < 20000; ++i)
+	{
+		const auto e = world.entity();
+		world.set<Position>(e, Position { 0.0f, 0.0f, 0.0f });
+		world.set<Velocity>(e, Velocity { static_cast<float>(i), 1.0f, 0.0f });
+		if (i % 2 == 0)
+			world.set<Health>(e, Health { i });
+	}
+
+	ncs::ThreadPool pool(4);
+	std::atomic<int> visited = 0;
+	world.par_each<Position, const Velocity>(pool, [&visited](Position &pos, const Velocity &vel)
+	{
+		pos.x += vel.x;
+		pos.y += vel.y;
+		visited.fetch_add(1, std::memory_order_relaxed);
+	}, 100);
+
+	EXPECT_EQ(visited.load(), 20000);
+	world.each<const Position, const Velocity>([](const Position &pos, const Velocity &vel)
+	{
+		EXPECT_EQ(pos.x, vel.x);
+		EXPECT_EQ(pos.y, 1.0f);
+	});
+}
+
+TEST(ParallelEachTest, ChunkedWithEntity)
+{
+	ncs::World world(ncs::Storage::CHUNKED);
+	for (auto i = 0; i < 5000; ++i)
+		world.set<Health>(world.entity(), Health { 1 });
+
+	ncs::ThreadPool pool(3);
+	world.par_each<Health>(pool, [&world](const ncs::Entity e, Health &health)
+	{
+		EXPECT_EQ(world.get<Health>(e), &health);
+		health.value += 1;
+	});
+
+	auto sum = 0;
+	world.each<const Health>([&sum](const Health &health) { sum += health.value; });
+	EXPECT_EQ(sum, 10000);
+}
+
+TEST(SchedulerTest, Stages)
+{
+	ncs::World world;
+	ncs::ThreadPool pool(2);
+	ncs::Scheduler scheduler(world, pool);
+
+	scheduler.system<const Velocity, Position>([](const Velocity &, Position &) {}); /* 0 */
+	scheduler.system<AI>([](AI &) {});                                              /* 1; disjoint from 0 */
+	scheduler.system<Health>([](Health &) {});                                      /* 2; disjoint from 0 and 1 */
+	scheduler.system<const Position, AI>([](const Position &, AI &) {});            /* 3; after 0 and 1 */
+	scheduler.system<const Position>([](const Position &) {});                      /* 4; shares a read with 3 */
+	scheduler.system<const Health>([](ncs::World &) {});                           /* 5; whole world, so alone */
+	scheduler.system<const Velocity>([](const Velocity &) {});                      /* 6; after 5 like everything */
+
+	const auto &stages = scheduler.stages();
+	ASSERT_EQ(stages.size(), 4);
+	EXPECT_EQ(stages[0], (std::vector<size_t> { 0, 1, 2 }));
+	EXPECT_EQ(stages[1], (std::vector<size_t> { 3, 4 }));
+	EXPECT_EQ(stages[2], (std::vector<size_t> { 5 }));
+	EXPECT_EQ(stages[3], (std::vector<size_t> { 6 }));
+}
+
+TEST(SchedulerTest, RunsInDependencyOrder)
+{
+	ncs::World world;
+	for (auto i = 0; i < 1000; ++i)
+	{
+		const auto e = world.entity();
+		world.set<Position>(e, Position { 0.0f, 0.0f, 0.0f });
+		world.set<Velocity>(e, Velocity { 1.0f, 0.0f, 0.0f });
+		world.set<Health>(e, Health { 0 });
+		world.set<AI>(e, AI { 0 });
+	}
+
+	ncs::ThreadPool pool(4);
+	ncs::Scheduler scheduler(world, pool);
+
+	scheduler
+			.system<const Velocity, Position>([](const Velocity &vel, Position &pos)
+			{
+				pos.x += vel.x;
+			})
+			.system<Health>([](Health &health)
+			{
+				health.value += 1;
+			})
+			.system<const Position, AI>([](const Position &pos, AI &ai)
+			{
+				/* must observe the movement of the same frame */
+				ai.state = static_cast<int>(pos.x);
+			});
+
+	for (auto frame = 0; frame < 3; ++frame)
+		scheduler.run();
+
+	world.each<const Position, const Health, const AI>([](const Position &pos, const Health &health, const AI &ai)
+	{
+		EXPECT_EQ(pos.x, 3.0f);
+		EXPECT_EQ(health.value, 3);
+		EXPECT_EQ(ai.state, 3);
+	});
+}
+
+TEST(SchedulerTest, WholeWorldSystemBesideRowSystems)
+{
+	ncs::World world;
+	for (auto i = 0; i < 5000; ++i)
+		world.set(world.entity(), Position { 0.0f, 0.0f, 0.0f }, Velocity { 1.0f, 0.0f, 0.0f }, Health { 0 }, AI { 0 });
+
+	ncs::ThreadPool pool(4);
+	ncs::Scheduler scheduler(world, pool);
+
+	/* the World & system resolves its query on first use; row systems must not be looking states up meanwhile */
+	std::atomic<size_t> rows = 0;
+	scheduler
+			.system<const Velocity, Position>([](const Velocity &vel, Position &pos)
+			{
+				pos.x += vel.x;
+			})
+			.system<AI>([](AI &ai)
+			{
+				ai.state += 1;
+			})
+			.system<Health>([&pool, &rows](ncs::World &w)
+			{
+				w.par_each<Health>(pool, [&rows](Health &hp)
+				{
+					hp.value += 1;
+					rows.fetch_add(1, std::memory_order_relaxed);
+				});
+				EXPECT_EQ((w.query<Health, AI>().size()), 5000);
+			});
+
+	EXPECT_EQ(scheduler.stages().size(), 2);
+	for (auto frame = 0; frame < 3; ++frame)
+		scheduler.run();
+
+	EXPECT_EQ(rows.load(), 15000);
+	world.each<const Position, const Health, const AI>([](const Position &pos, const Health &health, const AI &ai)
+	{
+		EXPECT_EQ(pos.x, 3.0f);
+		EXPECT_EQ(health.value, 3);
+		EXPECT_EQ(ai.state, 3);
+	});
+}
@@ -0,0 +1,105 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <memory>
+#include <string>
+#include <gtest/gtest.h>
+#include <ncs/world/prefab.hpp>
+#include <ncs/world/world.hpp>
+
+struct Position
+{
+	float x, y, z;
+};
+
+struct Health
+{
+	int value;
+};
+
+struct Label
+{
+	std::string text;
+};
+
+struct Hostile {};
+
+struct Loadout
+{
+	int weapon = 0;
+
+	bool operator==(const Loadout &) const = default;
+};
+
+TEST(PrefabTest, InstancesCopyTheDefaults)
+{
+	ncs::World world;
+	ncs::Prefab prefab(world);
+	prefab.set(Position { 1, 2, 3 }).set(Health { 50 }).set(Label { "grunt" }).set<Hostile>({});
+	prefab.set(Health { 100 }); /* a later default replaces the earlier one */
+
+	const std::vector<ncs::Entity> units = world.instantiate(prefab, 1000);
+	ASSERT_EQ(units.size(), 1000);
+	EXPECT_EQ(world.archetype_of(units.front()), prefab.archetype());
+	for (const ncs::Entity e: units)
+	{
+		EXPECT_EQ(world.get<Position>(e)->z, 3.0f);
+		EXPECT_EQ(world.get<Health>(e)->value, 100);
+		EXPECT_EQ(world.get<Label>(e)->text, "grunt");
+		EXPECT_TRUE(world.has<Hostile>(e));
+	}
+
+	/* instances are ordinary entities */
+	world.remove<Hostile>(units[7]);
+	world.despawn(units[8]);
+	EXPECT_EQ(world.get<Label>(units[7])->text, "grunt");
+
+	size_t added = 0;
+	world.each<ncs::Added<Health> >([&added](const Health &)
+	{
+		++added;
+	});
+	EXPECT_EQ(added, 999);
+}
+
+TEST(PrefabTest, OverridesAndChunks)
+{
+	ncs::World world(ncs::Storage::CHUNKED);
+	ncs::Prefab prefab(world);
+	prefab.set(Position { 0, 0, 0 }).set(Label { "unit" });
+
+	/* enough rows to span several chunks; the override sees every instance once */
+	const auto units = world.instantiate<Position, Label>(prefab, 5000, [](const size_t i, Position &p, Label &l)
+	{
+		p.x = static_cast<float>(i);
+		l.text += std::to_string(i);
+	});
+
+	for (size_t i = 0; i < units.size(); ++i)
+	{
+		EXPECT_EQ(world.get<Position>(units[i])->x, static_cast<float>(i));
+		EXPECT_EQ(world.get<Label>(units[i])->text, "unit" + std::to_string(i));
+	}
+}
+
+TEST(PrefabTest, SharedValues)
+{
+	ncs::World world;
+	std::vector<ncs::Entity> units;
+	{
+		ncs::Prefab prefab(world);
+		prefab.set(Health { 10 }).set_shared(Loadout { 1 });
+		prefab.set_shared(Loadout { 2 }); /* the first value is dropped, nothing held it */
+
+		units = world.instantiate(prefab, 3);
+		EXPECT_EQ(world.get_shared<Loadout>(units[0])->weapon, 2);
+		EXPECT_EQ(world.get_shared<Loadout>(units[0]), world.get_shared<Loadout>(units[2]));
+	}
+
+	/* the prefab is gone; its instances keep the value alive */
+	world.despawn(units[0]);
+	world.remove_shared<Loadout>(units[1]);
+	EXPECT_EQ(world.get_shared<Loadout>(units[2])->weapon, 2);
+
+	world.set_shared(units[1], Loadout { 2 });
+	EXPECT_EQ(world.archetype_of(units[1]), world.archetype_of(units[2]));
+}
@@ -259,6 +259,34 @@ TEST(WorldTest, ComponentOrderInQuery)
 	EXPECT_EQ(vel2->x, 10.0f);
 }
 
+TEST(WorldTest, ReorderedTermsShareMatches)
+{
+	ncs::World world;
+
+	const auto a = world.entity();
+	world.set(a, Position(1), Tag1 {});
+	const auto b = world.entity();
+	world.set(b, Position(2), Velocity(), Tag2 {});
+
+	/* the same terms in two orders; Or groups swapped too */
+	const auto rows = [&world]
+	{
+		size_t forward = 0, backward = 0;
+		world.each<ncs::Or<Tag1, Tag2>, Position, ncs::Without<Health>, ncs::Or<Velocity, Tag1> >(
+			[&forward](const Position &) { ++forward; });
+		world.each<ncs::Or<Tag1, Velocity>, ncs::Without<Health>, Position, ncs::Or<Tag2, Tag1> >(
+			[&backward](const Position &) { ++backward; });
+		return std::pair { forward, backward };
+	};
+
+	EXPECT_EQ(rows(), std::make_pair(size_t { 2 }, size_t { 2 }));
+
+	/* archetypes created later reach both orders */
+	world.set(world.entity(), Position(3), Velocity(), Tag1 {}, Tag3 {});
+	world.set(world.entity(), Position(4), Velocity(), Health());
+	EXPECT_EQ(rows(), std::make_pair(size_t { 3 }, size_t { 3 }));
+}
+
 TEST(WorldTest, MultipleArchetype)
 {
 	ncs::World world;
@@ -342,3 +370,293 @@ TEST(WorldTest, LargeQuery)
 	const auto q4 = world.query<Position, Velocity, Health>();
 	EXPECT_EQ(q4.size(), 1000 / 15 + (1000 % 15 > 0 ? 1 : 0));
 }
+
+TEST(WorldTest, EachRow)
+{
+	ncs::World world;
+	for (auto i = 0; i < 6; ++i)
+	{
+		const auto e = world.entity();
+		world.set<Position>(e, Position { static_cast<float>(i), 0.0f, 0.0f });
+		world.set<Velocity>(e, Velocity { 1.0f, 0.0f, 0.0f });
+		if (i % 2 == 0)
+			world.set<Health>(e, Health { i });
+	}
+
+	/* spans two archetypes; {Position, Velocity} and {Position, Velocity, Health} */
+	auto visited = 0;
+	world.each<Position, const Velocity>([&visited](Position &pos, const Velocity &vel)
+	{
+		pos.x += vel.x;
+		++visited;
+	});
+	EXPECT_EQ(visited, 6);
+
+	auto sum = 0.0f;
+	world.each<Position>([&world, &sum](const ncs::Entity e, const Position &pos)
+	{
+		EXPECT_TRUE(world.has<Position>(e));
+		EXPECT_EQ(world.get<Position>(e)->x, pos.x);
+		sum += pos.x;
+	});
+	EXPECT_EQ(sum, 0.0f + 1 + 2 + 3 + 4 + 5 + 6);
+}
+
+TEST(WorldTest, EachChunk)
+{
+	ncs::World world;
+	for (auto i = 0; i < 100; ++i)
+	{
+		const auto e = world.entity();
+		world.set<Position>(e, Position { static_cast<float>(i), 0.0f, 0.0f });
+		if (i % 4 == 0)
+			world.set<Health>(e, Health { i });
+	}
+
+	size_t rows = 0;
+	size_t chunks = 0;
+	world.each_chunk<Position>([&](const std::span<const ncs::Entity> entities, const std::span<Position> positions)
+	{
+		ASSERT_EQ(entities.size(), positions.size());
+		for (size_t i = 0; i < entities.size(); ++i)
+			EXPECT_EQ(world.get<Position>(entities[i]), &positions[i]); /* no copies */
+
+		rows += positions.size();
+		++chunks;
+	});
+
+	EXPECT_EQ(rows, 100);
+	EXPECT_EQ(chunks, 2);
+}
+
+TEST(WorldTest, EachSkipsEmpty)
+{
+	ncs::World world;
+
+	const auto e = world.entity();
+	world.set<Position>(e, Position { 1.0f, 2.0f, 3.0f });
+	world.despawn(e);
+
+	auto visited = 0;
+	world.each<Position>([&visited](Position &) { ++visited; });
+	EXPECT_EQ(visited, 0);
+}
+
+TEST(WorldTest, CacheAcrossArchetypes)
+{
+	ncs::World world;
+
+	const auto e1 = world.entity();
+	const auto e2 = world.entity();
+	world.set<Position>(e1, Position { 1.0f, 0.0f, 0.0f });
+	world.set<Position>(e2, Position { 2.0f, 0.0f, 0.0f });
+	world.set<Velocity>(e2, Velocity { 0.0f, 0.0f, 0.0f });
+
+	EXPECT_EQ(world.query<Position>().size(), 2);
+	EXPECT_EQ((world.query<Position, Velocity>().size()), 1);
+
+	/* add to the first matched archetype; both caches must see it */
+	const auto e3 = world.entity();
+	world.set<Position>(e3, Position { 3.0f, 0.0f, 0.0f });
+	EXPECT_EQ(world.query<Position>().size(), 3);
+
+	/* a matching archetype created after the cache was built */
+	const auto e4 = world.entity();
+	world.set<Position>(e4, Position { 4.0f, 0.0f, 0.0f });
+	world.set<Health>(e4, Health { 4 });
+	EXPECT_EQ(world.query<Position>().size(), 4);
+	EXPECT_EQ((world.query<Position, Velocity>().size()), 1);
+
+	/* removals in several archetypes between two calls */
+	world.despawn(e1);
+	world.despawn(e4);
+	const auto q = world.query<Position>();
+	ASSERT_EQ(q.size(), 2);
+	for (auto &[e, pos]: q)
+	{
+		EXPECT_TRUE(e == e2 || e == e3);
+		EXPECT_EQ(world.get<Position>(e), pos);
+	}
+
+	/* a steady-state call reads the cache in place */
+	const auto first = world.query<Position>();
+	EXPECT_EQ(&*first.begin(), &*world.query<Position>().begin());
+
+	/* a spawn rebuilds the rows of its archetype only; e2's archetype keeps its cached rows where they are */
+	const auto *untouched = &*std::ranges::find(first, e2, [](const auto &row) { return std::get<0>(row); });
+	world.set<Position>(world.entity(), Position { 5.0f, 0.0f, 0.0f });
+	const auto after = world.query<Position>();
+	ASSERT_EQ(after.size(), 3);
+	EXPECT_EQ(&*std::ranges::find(after, e2, [](const auto &row) { return std::get<0>(row); }), untouched);
+	for (size_t i = 0; i < after.size(); ++i)
+		EXPECT_EQ(world.get<Position>(std::get<0>(after[i])), std::get<1>(after[i]));
+}
+
+TEST(WorldTest, CachePointersAfterGrowth)
+{
+	ncs::World world;
+
+	const auto first = world.entity();
+	world.set<Position>(first, Position { 1.0f, 2.0f, 3.0f });
+	EXPECT_EQ(world.query<Position>().size(), 1);
+
+	/* grow the column past its initial capacity so the old rows move */
+	for (auto i = 0; i < 100; ++i)
+		world.set<Position>(world.entity(), Position { 0.0f, 0.0f, 0.0f });
+
+	const auto q = world.query<Position>();
+	ASSERT_EQ(q.size(), 101);
+	for (auto &[e, pos]: q)
+		EXPECT_EQ(world.get<Position>(e), pos);
+}
+
+TEST(WorldTest, ChangedAndAdded)
+{
+	ncs::World world;
+
+	std::vector<ncs::Entity> entities;
+	for (int i = 0; i < 100; ++i)
+	{
+		const auto e = world.entity();
+		world.set(e, Position(static_cast<float>(i)));
+		entities.emplace_back(e);
+	}
+
+	/* everything was added and written in the first tick */
+	size_t rows = 0;
+	world.each<ncs::Added<Position> >([&rows](const Position &) { ++rows; });
+	EXPECT_EQ(rows, 100);
+
+	const ncs::Tick frame = world.advance();
+	rows = 0;
+	world.each<ncs::Changed<Position> >([&rows](const Position &) { ++rows; });
+	EXPECT_EQ(rows, 0);
+
+	/* a write, an in-place edit marked by hand and a transition that only adds Health */
+	world.set(entities[3], Position(-3));
+	world.get<Position>(entities[5])->x = -5;
+	world.mark_changed<Position>(entities[5]);
+	world.set(entities[7], Health(7));
+
+	std::vector<ncs::Entity> changed;
+	world.each<ncs::Changed<Position> >([&changed](const ncs::Entity e, const Position &p)
+	{
+		EXPECT_LT(p.x, 0);
+		changed.emplace_back(e);
+	});
+	std::ranges::sort(changed);
+	EXPECT_EQ(changed, (std::vector { entities[3], entities[5] }));
+
+	/* entity 7 moved archetypes but its Position keeps its history */
+	std::vector<ncs::Entity> added;
+	world.each<Position, ncs::Added<Health> >([&added](const ncs::Entity e, Position &, Health &h)
+	{
+		EXPECT_EQ(h.value, 7);
+		added.emplace_back(e);
+	});
+	EXPECT_EQ(added, (std::vector { entities[7] }));
+
+	rows = 0;
+	world.each<ncs::Added<Position> >([&rows](const Position &) { ++rows; });
+	EXPECT_EQ(rows, 0);
+
+	/* swap-remove carries ticks with the row */
+	world.despawn(entities[0]);
+	world.advance();
+	world.set(entities[99], Position(-99));
+	rows = 0;
+	world.each<ncs::Changed<Position> >([&rows](const Position &p)
+	{
+		EXPECT_EQ(p.x, -99);
+		++rows;
+	});
+	EXPECT_EQ(rows, 1);
+
+	/* an older tick sees everything since */
+	rows = 0;
+	world.each<ncs::Changed<Position> >(frame, [&rows](const Position &) { ++rows; });
+	EXPECT_EQ(rows, 3);
+}
+
+TEST(WorldTest, ChangedSkipsUntouchedArchetypes)
+{
+	ncs::World world;
+	const auto batch = world.spawn_batch<Position, Velocity>(1000, [](size_t, Position &, Velocity &) {});
+	const auto e = world.entity();
+	world.set(e, Position(1))->set(e, Health(1));
+
+	world.advance();
+	world.set(e, Position(2));
+
+	const ncs::Archetype *untouched = world.archetype_of(batch[0]);
+	EXPECT_LT(untouched->column(world.component<Position>())->changed_max, world.tick());
+
+	size_t rows = 0;
+	world.each<ncs::Changed<Position> >([&rows](const Position &p)
+	{
+		EXPECT_EQ(p.x, 2);
+		++rows;
+	});
+	EXPECT_EQ(rows, 1);
+}
+
+TEST(WorldTest, FilterTerms)
+{
+	ncs::World world;
+
+	/* 0: P, 1: P V, 2: P Tag1, 3: P V Tag1, 4: P Health, 5: V */
+	std::vector<ncs::Entity> e;
+	for (int i = 0; i < 6; ++i)
+		e.emplace_back(world.entity());
+
+	world.set(e[0], Position(0));
+	world.set(e[1], Position(1))->set(e[1], Velocity(1));
+	world.set(e[2], Position(2))->set(e[2], Tag1 {});
+	world.set(e[3], Position(3))->set(e[3], Velocity(3))->set(e[3], Tag1 {});
+	world.set(e[4], Position(4))->set(e[4], Health(4));
+	world.set(e[5], Velocity(5));
+
+	const auto visit = [&world]<typename... Terms>()
+	{
+		std::vector<int> seen;
+		world.each<Terms...>([&seen](const ncs::Entity entity, auto &&...)
+		{
+			seen.emplace_back(static_cast<int>(ncs::World::get_eid(entity)));
+		});
+		std::ranges::sort(seen);
+		return seen;
+	};
+
+	EXPECT_EQ((visit.operator()<Position, ncs::Without<Tag1> >()), (std::vector { 0, 1, 4 }));
+	EXPECT_EQ((visit.operator()<ncs::With<Tag1> >()), (std::vector { 2, 3 }));
+	EXPECT_EQ((visit.operator()<Position, ncs::With<Velocity>, ncs::Without<Tag1> >()), (std::vector { 1 }));
+	EXPECT_EQ((visit.operator()<ncs::Or<Velocity, Health> >()), (std::vector { 1, 3, 4, 5 }));
+	EXPECT_EQ((visit.operator()<Position, ncs::Or<Tag1, Health>, ncs::Without<Velocity> >()), (std::vector { 2, 4 }));
+
+	/* With and Without pass nothing; Optional passes a pointer that is null where the component is missing */
+	int with_velocity = 0;
+	int total = 0;
+	world.each<Position, ncs::Optional<Velocity>, ncs::Without<Health> >([&](Position &p, const Velocity *v)
+	{
+		++total;
+		if (v)
+		{
+			EXPECT_EQ(v->x, p.x);
+			++with_velocity;
+		}
+	});
+	EXPECT_EQ(total, 4);
+	EXPECT_EQ(with_velocity, 2);
+
+	/* archetypes created afterwards are matched the same way */
+	const auto late = world.entity();
+	world.set(late, Position(9))->set(late, Health(9))->set(late, Tag1 {});
+	EXPECT_EQ((visit.operator()<Position, ncs::Or<Tag1, Health>, ncs::Without<Velocity> >()),
+	          (std::vector { 2, 4, static_cast<int>(ncs::World::get_eid(late)) }));
+
+	/* filter terms combine with change filters */
+	world.advance();
+	world.set(e[1], Position(10));
+	world.set(e[3], Position(30));
+	EXPECT_EQ((visit.operator()<ncs::Changed<Position>, ncs::Without<Tag1> >()), (std::vector { 1 }));
+}
@@ -0,0 +1,120 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <ncs/world/world.hpp>
+
+struct Position
+{
+	float x, y, z;
+};
+
+struct ChildOf {};
+
+struct Targets {};
+
+TEST(RelationTest, AddHasRemove)
+{
+	ncs::World world;
+	const ncs::Entity parent = world.entity();
+	const ncs::Entity child = world.entity();
+	world.set(child, Position { 1, 2, 3 });
+
+	EXPECT_EQ(world.pair<ChildOf>(parent), 0);
+	world.add<ChildOf>(child, parent);
+	EXPECT_TRUE(world.has<ChildOf>(child, parent));
+	EXPECT_FALSE(world.has<Targets>(child, parent));
+	EXPECT_FALSE(world.has<ChildOf>(parent, child));
+
+	/* the pair is an id of the archetype; data columns move along as usual */
+	const ncs::Component id = world.pair<ChildOf>(parent);
+	EXPECT_NE(id & ncs::PAIR_FLAG, 0);
+	EXPECT_TRUE(world.archetype_of(child)->has(id));
+	EXPECT_EQ(world.get<Position>(child)->y, 2.0f);
+	EXPECT_EQ(world.targets<ChildOf>(child), std::vector<ncs::Entity> { parent });
+
+	world.remove<ChildOf>(child, parent);
+	EXPECT_FALSE(world.has<ChildOf>(child, parent));
+	EXPECT_TRUE(world.targets<ChildOf>(child).empty());
+	EXPECT_EQ(world.get<Position>(child)->z, 3.0f);
+
+	/* dead targets are refused */
+	const ncs::Entity dead = world.entity();
+	world.despawn(dead);
+	world.add<ChildOf>(child, dead);
+	EXPECT_FALSE(world.has<ChildOf>(child, dead));
+}
+
+TEST(RelationTest, ReverseIndex)
+{
+	ncs::World world;
+	const ncs::Entity a = world.entity();
+	const ncs::Entity b = world.entity();
+
+	std::vector<ncs::Entity> children;
+	for (int i = 0; i < 10; ++i)
+	{
+		const ncs::Entity e = world.entity();
+		if (i % 2)
+			world.set(e, Position { static_cast<float>(i), 0, 0 });
+		world.add<ChildOf>(e, i < 6 ? a : b);
+		world.add<Targets>(e, b);
+		if (i < 6)
+			children.emplace_back(e);
+	}
+
+	/* children of a sit in two archetypes, with and without Position */
+	std::vector<ncs::Entity> found;
+	world.each_source<ChildOf>(a, [&found](const ncs::Entity e) { found.emplace_back(e); });
+	std::ranges::sort(found);
+	EXPECT_EQ(found, children);
+
+	size_t targeting = 0;
+	world.each_source<Targets>(b, [&targeting](ncs::Entity) { ++targeting; });
+	EXPECT_EQ(targeting, 10);
+
+	/* entities sharing a parent share an archetype */
+	EXPECT_EQ(world.archetype_of(children[0]), world.archetype_of(children[2]));
+	EXPECT_NE(world.archetype_of(children[0]), world.archetype_of(children[1]));
+
+	/* several targets of one relation */
+	world.add<Targets>(children[0], a);
+	std::vector<ncs::Entity> targets = world.targets<Targets>(children[0]);
+	std::ranges::sort(targets);
+	EXPECT_EQ(targets, (std::vector<ncs::Entity> { a, b }));
+}
+
+TEST(RelationTest, DespawnedTargetsAreReleased)
+{
+	ncs::World world;
+	const ncs::Entity parent = world.entity();
+	const ncs::Entity other = world.entity();
+
+	std::vector<ncs::Entity> children;
+	for (int i = 0; i < 5; ++i)
+	{
+		const ncs::Entity e = world.entity();
+		world.set(e, Position { static_cast<float>(i), 0, 0 });
+		world.add<ChildOf>(e, parent);
+		world.add<Targets>(e, other);
+		children.emplace_back(e);
+	}
+
+	world.despawn(parent);
+	for (size_t i = 0; i < children.size(); ++i)
+	{
+		EXPECT_TRUE(world.alive(children[i]));
+		EXPECT_TRUE(world.targets<ChildOf>(children[i]).empty());
+		EXPECT_TRUE(world.has<Targets>(children[i], other));
+		EXPECT_EQ(world.get<Position>(children[i])->x, static_cast<float>(i));
+	}
+
+	/* the freed id is handed to the next pair; the old holders are not confused for its holders */
+	const ncs::Entity next = world.entity();
+	world.add<ChildOf>(children[0], next);
+	size_t rows = 0;
+	world.each_source<ChildOf>(next, [&rows](ncs::Entity) { ++rows; });
+	EXPECT_EQ(rows, 1);
+	EXPECT_EQ(world.targets<ChildOf>(children[0]), std::vector<ncs::Entity> { next });
+	EXPECT_FALSE(world.has<ChildOf>(children[1], next));
+}
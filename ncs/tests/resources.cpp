@@ -0,0 +1,70 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <memory>
+#include <string>
+#include <gtest/gtest.h>
+#include <ncs/world/world.hpp>
+
+struct Time
+{
+	float delta = 0;
+	float elapsed = 0;
+};
+
+struct Camera
+{
+	std::string name;
+	std::shared_ptr<int> handle;
+};
+
+struct Position
+{
+	float x, y, z;
+};
+
+TEST(ResourceTest, InsertAndRead)
+{
+	ncs::World world;
+	EXPECT_EQ(world.resource<Time>(), nullptr);
+
+	Time &time = world.insert_resource<Time>(0.016f, 0.0f);
+	EXPECT_EQ(world.resource<Time>(), &time);
+	EXPECT_EQ(world.resource<const Time>()->delta, 0.016f);
+
+	world.resource<Time>()->elapsed += 1.0f;
+	EXPECT_EQ(time.elapsed, 1.0f);
+
+	/* resources never show up in archetypes */
+	const ncs::Entity e = world.entity();
+	world.set(e, Position { 1, 2, 3 });
+	size_t rows = 0;
+	world.each<Position>([&rows](const Position &) { ++rows; });
+	EXPECT_EQ(rows, 1);
+	EXPECT_EQ(world.resource<Position>(), nullptr);
+}
+
+TEST(ResourceTest, ReplaceAndRemove)
+{
+	const auto handle = std::make_shared<int>(7);
+	{
+		ncs::World world;
+		world.insert_resource<Camera>("main", handle);
+		EXPECT_EQ(handle.use_count(), 2);
+
+		/* the old value is destroyed after the new one is built from it */
+		world.insert_resource<Camera>(world.resource<Camera>()->name + " copy", nullptr);
+		EXPECT_EQ(world.resource<Camera>()->name, "main copy");
+		EXPECT_EQ(handle.use_count(), 1);
+
+		world.insert_resource<Camera>("again", handle);
+		world.remove_resource<Camera>();
+		EXPECT_EQ(world.resource<Camera>(), nullptr);
+		EXPECT_EQ(handle.use_count(), 1);
+
+		world.remove_resource<Camera>(); /* no-op */
+		world.insert_resource<Camera>("shutdown", handle);
+	}
+
+	/* the world releases what is left */
+	EXPECT_EQ(handle.use_count(), 1);
+}
@@ -0,0 +1,117 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <memory>
+#include <string>
+#include <gtest/gtest.h>
+#include <ncs/world/world.hpp>
+
+struct Tuning
+{
+	std::string profile;
+	float aggression = 0;
+	std::shared_ptr<int> handle; /* not compared; counts the live copies */
+
+	bool operator==(const Tuning &other) const
+	{
+		return profile == other.profile && aggression == other.aggression;
+	}
+};
+
+struct Position
+{
+	float x, y, z;
+};
+
+TEST(SharedTest, EqualValuesShareOneCopy)
+{
+	ncs::World world;
+	const auto handle = std::make_shared<int>(0);
+
+	std::vector<ncs::Entity> crowd;
+	for (int i = 0; i < 100; ++i)
+	{
+		const ncs::Entity e = world.entity();
+		world.set(e, Position { static_cast<float>(i), 0, 0 });
+		world.set_shared(e, Tuning { "grunt", 0.5f, handle });
+		crowd.emplace_back(e);
+	}
+
+	const ncs::Entity boss = world.entity();
+	world.set_shared(boss, Tuning { "boss", 1.0f, handle });
+	world.set(boss, Position { -1, 0, 0 });
+
+	/* one copy per distinct value, not per row */
+	EXPECT_EQ(handle.use_count(), 3);
+	EXPECT_EQ(world.get_shared<Tuning>(crowd[0]), world.get_shared<Tuning>(crowd[99]));
+	EXPECT_NE(world.get_shared<Tuning>(crowd[0]), world.get_shared<Tuning>(boss));
+	EXPECT_EQ(world.get_shared<Tuning>(boss)->profile, "boss");
+	EXPECT_EQ(world.archetype_of(crowd[0]), world.archetype_of(crowd[42]));
+	EXPECT_EQ(world.archetype_of(crowd[0])->column(world.component<Tuning>()), nullptr);
+	EXPECT_TRUE(world.has<ncs::Shared<Tuning> >(boss));
+
+	/* transitions carry the value id along; nothing is copied */
+	world.remove<Position>(crowd[1]);
+	EXPECT_EQ(world.get_shared<Tuning>(crowd[1]), world.get_shared<Tuning>(crowd[0]));
+	EXPECT_EQ(handle.use_count(), 3);
+
+	size_t grunts = 0, bosses = 0;
+	world.each<Position, ncs::Shared<Tuning> >([&](const ncs::Entity e, const Position &p, const Tuning &t)
+	{
+		EXPECT_EQ(&t, world.get_shared<Tuning>(e));
+		if (t.profile == "grunt")
+			++grunts;
+		else
+			bosses += p.x == -1;
+	});
+	EXPECT_EQ(grunts, 99);
+	EXPECT_EQ(bosses, 1);
+}
+
+TEST(SharedTest, LastHolderReleasesTheValue)
+{
+	ncs::World world;
+	const auto handle = std::make_shared<int>(0);
+
+	const ncs::Entity a = world.entity();
+	const ncs::Entity b = world.entity();
+	world.set_shared(a, Tuning { "scout", 0.1f, handle });
+	world.set_shared(b, Tuning { "scout", 0.1f, handle });
+	EXPECT_EQ(handle.use_count(), 2);
+
+	/* a new value moves the entity; the old one survives while b holds it */
+	world.set_shared(a, Tuning { "sniper", 0.9f, handle });
+	EXPECT_EQ(handle.use_count(), 3);
+	EXPECT_EQ(world.get_shared<Tuning>(a)->profile, "sniper");
+	EXPECT_EQ(world.get_shared<Tuning>(b)->profile, "scout");
+
+	world.despawn(b);
+	EXPECT_EQ(handle.use_count(), 2);
+
+	world.remove_shared<Tuning>(a);
+	EXPECT_EQ(handle.use_count(), 1);
+	EXPECT_EQ(world.get_shared<Tuning>(a), nullptr);
+	EXPECT_FALSE(world.has<ncs::Shared<Tuning> >(a));
+
+	/* a freed id is reused for the next value */
+	const ncs::Entity c = world.entity();
+	world.set_shared(c, Tuning { "medic", 0.2f, handle });
+	world.set(c, Position { 1, 2, 3 });
+	EXPECT_EQ(world.get_shared<Tuning>(c)->profile, "medic");
+	EXPECT_EQ(world.get<Position>(c)->y, 2.0f);
+
+	size_t rows = 0;
+	world.each<ncs::Shared<Tuning> >([&rows](const Tuning &t)
+	{
+		EXPECT_EQ(t.profile, "medic");
+		++rows;
+	});
+	EXPECT_EQ(rows, 1);
+
+	/* the world drops values still held at shutdown */
+	{
+		ncs::World other;
+		other.set_shared(other.entity(), Tuning { "left over", 0, handle });
+		EXPECT_EQ(handle.use_count(), 3);
+	}
+	EXPECT_EQ(handle.use_count(), 2);
+}
@@ -0,0 +1,327 @@
+/* this file is a part of Naught Engine which is under MIT license; see LICENSE for more info */
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <gtest/gtest.h>
+#include <ncs/world/snapshot.hpp>
+#include <ncs/world/world.hpp>
+
+struct Position
+{
+	float x, y, z;
+};
+
+struct Velocity
+{
+	float x, y, z;
+};
+
+struct Frozen {};
+
+struct Name
+{
+	std::string name;
+};
+
+struct ChildOf {};
+
+static std::string temp(const char *name)
+{
+	return testing::TempDir() + name;
+}
+
+/* a world as saved; one entity in each of three archetypes per i */
+static std::vector<ncs::Entity> populate(ncs::World &world, const int count)
+{
+	std::vector<ncs::Entity> handles;
+	for (int i = 0; i < count; ++i)
+	{
+		const ncs::Entity a = world.entity();
+		world.set(a, Position { static_cast<float>(i), 1, 2 });
+
+		const ncs::Entity b = world.entity();
+		world.set(b, Position { static_cast<float>(i), 3, 4 }, Velocity { 1, 0, 0 });
+
+		const ncs::Entity c = world.entity();
+		world.set(c, Velocity { 0, static_cast<float>(i), 0 });
+		world.set<Frozen>(c, {});
+		handles.insert(handles.end(), { a, b, c });
+	}
+
+	/* freed ids and bumped generations must come back as they were */
+	for (int i = 0; i < count; i += 7)
+		world.despawn(handles[i]);
+	return handles;
+}
+
+static void expect_same(ncs::World &world, ncs::World &restored, const std::vector<ncs::Entity> &handles)
+{
+	for (const ncs::Entity e: handles)
+	{
+		ASSERT_EQ(world.alive(e), restored.alive(e));
+		if (!world.alive(e))
+			continue;
+
+		EXPECT_EQ(world.has<Frozen>(e), restored.has<Frozen>(e));
+		if (const Position *p = world.get<Position>(e))
+		{
+			ASSERT_NE(restored.get<Position>(e), nullptr);
+			EXPECT_EQ(restored.get<Position>(e)->x, p->x);
+			EXPECT_EQ(restored.get<Position>(e)->z, p->z);
+		}
+
+		if (const Velocity *v = world.get<Velocity>(e))
+		{
+			ASSERT_NE(restored.get<Velocity>(e), nullptr);
+			EXPECT_EQ(restored.get<Velocity>(e)->y, v->y);
+		}
+	}
+}
+
+TEST(SnapshotTest, CopyRoundTrip)
+{
+	const std::string path = temp("ncs_copy.snapshot");
+	ncs::World world;
+	const auto handles = populate(world, 1000);
+	ASSERT_TRUE(world.save(path));
+
+	/* types are named by key; the loading world registers them first */
+	ncs::World restored(ncs::Storage::CHUNKED);
+	restored.component<Position>();
+	restored.component<Velocity>();
+	restored.component<Frozen>();
+	ASSERT_TRUE(restored.load(path, ncs::Restore::ADOPT)); /* chunked worlds copy */
+	expect_same(world, restored, handles);
+
+	/* the restored world is an ordinary one; a freed id comes back without reviving its old handle */
+	const ncs::Entity fresh = restored.entity();
+	restored.set(fresh, Position { 9, 9, 9 });
+	EXPECT_EQ(restored.get<Position>(fresh)->x, 9.0f);
+	EXPECT_FALSE(restored.alive(handles[0]));
+
+	/* restored rows count as added in the loading tick */
+	size_t saved = 0, loaded = 0;
+	world.each<Position>([&saved](const Position &)
+	{
+		++saved;
+	});
+	restored.each<ncs::Added<Position> >([&loaded](const Position &)
+	{
+		++loaded;
+	});
+	EXPECT_EQ(loaded, saved + 1);
+	std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, AdoptedColumnsGrowAndTakeWrites)
+{
+	const std::string path = temp("ncs_adopt.snapshot");
+	ncs::World world;
+	const auto handles = populate(world, 500);
+	ASSERT_TRUE(world.save(path));
+
+	{
+		ncs::World restored;
+		restored.component<Position>();
+		restored.component<Velocity>();
+		restored.component<Frozen>();
+		ASSERT_TRUE(restored.load(path, ncs::Restore::ADOPT));
+		expect_same(world, restored, handles);
+
+		/* writes land in private pages; appends copy the rows out of the file */
+		restored.get<Position>(handles[1])->x = -1;
+		for (int i = 0; i < 100; ++i)
+			restored.set(restored.entity(), Position { 0, 0, 0 });
+		restored.remove<Velocity>(handles[1]);
+		EXPECT_EQ(restored.get<Position>(handles[1])->x, -1.0f);
+		EXPECT_EQ(restored.get<Position>(handles[4])->y, 3.0f);
+	}
+
+	/* the file itself is unchanged */
+	ncs::World again;
+	again.component<Position>();
+	again.component<Velocity>();
+	again.component<Frozen>();
+	ASSERT_TRUE(again.load(path));
+	EXPECT_EQ(again.get<Position>(handles[1])->x, 0.0f);
+	std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, Refusals)
+{
+	const std::string path = temp("ncs_refused.snapshot");
+
+	ncs::World named;
+	named.set(named.entity(), Name { "not plain bytes" });
+	EXPECT_FALSE(named.save(path));
+
+	ncs::World linked;
+	const ncs::Entity parent = linked.entity();
+	linked.add<ChildOf>(linked.entity(), parent);
+	EXPECT_FALSE(linked.save(path));
+
+	ncs::World world;
+	populate(world, 10);
+	ASSERT_TRUE(world.save(path));
+
+	/* an unregistered type, a world with live entities, a truncated file */
+	ncs::World unregistered;
+	unregistered.component<Position>();
+	EXPECT_FALSE(unregistered.load(path));
+	EXPECT_EQ(unregistered.archetype_of(1), nullptr);
+
+	ncs::World busy;
+	busy.component<Position>();
+	busy.component<Velocity>();
+	busy.component<Frozen>();
+	const ncs::Entity e = busy.entity();
+	EXPECT_FALSE(busy.load(path));
+	busy.despawn(e);
+	EXPECT_TRUE(busy.load(path));
+
+	std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+
+	ncs::World truncated;
+	truncated.component<Position>();
+	truncated.component<Velocity>();
+	truncated.component<Frozen>();
+	EXPECT_FALSE(truncated.load(path));
+	EXPECT_FALSE(truncated.load(temp("ncs_missing.snapshot")));
+	std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, BareEntitiesAndBadHandles)
+{
+	const std::string path = temp("ncs_bare.snapshot");
+	ncs::World world;
+	const ncs::Entity bare = world.entity();
+	const ncs::Entity emptied = world.entity();
+	world.set(emptied, Position { 1, 2, 3 });
+	world.remove<Position>(emptied);
+	const ncs::Entity a = world.entity();
+	world.set(a, Position { 4, 5, 6 });
+	const ncs::Entity b = world.entity();
+	world.set(b, Position { 7, 8, 9 });
+	ASSERT_TRUE(world.save(path));
+
+	/* entities without components come back alive; their ids are not handed out again */
+	{
+		ncs::World restored;
+		restored.component<Position>();
+		ASSERT_TRUE(restored.load(path));
+		EXPECT_TRUE(restored.alive(bare));
+		EXPECT_TRUE(restored.alive(emptied));
+		EXPECT_FALSE(restored.has<Position>(emptied));
+		EXPECT_EQ(restored.archetype_of(bare), nullptr);
+		restored.set(bare, Velocity { 1, 0, 0 });
+		EXPECT_EQ(restored.get<Velocity>(bare)->x, 1.0f);
+
+		const ncs::Entity fresh = restored.entity();
+		EXPECT_NE(fresh, bare);
+		EXPECT_NE(fresh, emptied);
+		EXPECT_NE(fresh, a);
+		EXPECT_NE(fresh, b);
+	}
+
+	/* find the archetype's handle block and damage it */
+	std::string bytes;
+	{
+		std::ifstream in(path, std::ios::binary);
+		bytes.assign(std::istreambuf_iterator(in), {});
+	}
+
+	ncs::SnapshotHeader header;
+	std::memcpy(&header, bytes.data(), sizeof(header));
+	ASSERT_EQ(header.archetypes, 1u);
+	ncs::SnapshotArchetype table;
+	std::memcpy(&table, bytes.data() + sizeof(header), sizeof(table));
+	ASSERT_EQ(table.rows, 2u);
+
+	const auto refused = [&path, &bytes](const ncs::Entity first, const ncs::Entity second, const uint64_t at)
+	{
+		std::string damaged = bytes;
+		std::memcpy(damaged.data() + at, &first, sizeof(first));
+		std::memcpy(damaged.data() + at + sizeof(first), &second, sizeof(second));
+		std::ofstream(path, std::ios::binary | std::ios::trunc).write(damaged.data(), damaged.size());
+
+		ncs::World target;
+		target.component<Position>();
+		if (target.load(path))
+			return false;
+
+		/* nothing is touched; the world still hands out id 0 first */
+		EXPECT_EQ(ncs::World::get_eid(target.entity()), 0u);
+		return true;
+	};
+
+	EXPECT_TRUE(refused(a, a, table.entities)); /* a handle twice */
+	EXPECT_TRUE(refused(a, ncs::World::encode_entity(ncs::World::get_eid(b), ncs::World::get_egen(b) + 1),
+	                    table.entities)); /* a generation the file does not have */
+	EXPECT_FALSE(refused(a, b, table.entities));
+	std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, RepeatedComponentSets)
+{
+	const std::string path = temp("ncs_repeated.snapshot");
+	ncs::World world;
+	const ncs::Entity a = world.entity();
+	world.set(a, Position { 1, 0, 0 });
+	const ncs::Entity b = world.entity();
+	world.set(b, Velocity { 2, 0, 0 });
+	const ncs::Entity c = world.entity();
+	world.set(c, Position { 3, 0, 0 }, Velocity { 4, 0, 0 });
+	ASSERT_TRUE(world.save(path));
+
+	std::string bytes;
+	{
+		std::ifstream in(path, std::ios::binary);
+		bytes.assign(std::istreambuf_iterator(in), {});
+	}
+
+	ncs::SnapshotHeader header;
+	std::memcpy(&header, bytes.data(), sizeof(header));
+	ASSERT_EQ(header.archetypes, 3u);
+	ncs::SnapshotArchetype tables[3];
+	std::memcpy(tables, bytes.data() + sizeof(header), sizeof(tables));
+	ASSERT_EQ(tables[0].components, 1u);
+	ASSERT_EQ(tables[1].components, 1u);
+	ASSERT_EQ(tables[2].components, 2u);
+
+	/* offset of an entry's key, by table and column */
+	const auto key = [&tables](const size_t table, const size_t column)
+	{
+		return tables[table].columns + column * sizeof(ncs::SnapshotColumn) + offsetof(ncs::SnapshotColumn, key);
+	};
+
+	const auto loads = [&path](const std::string &file)
+	{
+		std::ofstream(path, std::ios::binary | std::ios::trunc).write(file.data(), file.size());
+		ncs::World target;
+		target.component<Position>();
+		target.component<Velocity>();
+		if (target.load(path, ncs::Restore::ADOPT))
+			return true;
+
+		/* nothing is touched; the world still hands out id 0 first */
+		EXPECT_EQ(ncs::World::get_eid(target.entity()), 0u);
+		return false;
+	};
+
+	/* two tables of Position */
+	std::string twice = bytes;
+	std::memcpy(twice.data() + key(1, 0), bytes.data() + key(0, 0), sizeof(uint64_t));
+	EXPECT_FALSE(loads(twice));
+
+	/* Position twice in one table */
+	std::string repeated = bytes;
+	std::memcpy(repeated.data() + key(2, 1), bytes.data() + key(2, 0), sizeof(uint64_t));
+	EXPECT_FALSE(loads(repeated));
+
+	EXPECT_TRUE(loads(bytes));
+	std::remove(path.c_str());
+}